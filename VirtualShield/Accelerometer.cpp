@@ -29,23 +29,20 @@ extern "C" {
 #include <stdlib.h>
 }
 
+const PROGMEM char FIELD_X[] = "X";
+const PROGMEM char FIELD_Y[] = "Y";
+const PROGMEM char FIELD_Z[] = "Z";
+
+// Fields read from events of this sensor.
+const PROGMEM SensorField ACCELEROMETER_FIELDS[] = {
+	{ FIELD_X, static_cast<double Sensor::*>(&Accelerometer::X) },
+	{ FIELD_Y, static_cast<double Sensor::*>(&Accelerometer::Y) },
+	{ FIELD_Z, static_cast<double Sensor::*>(&Accelerometer::Z) }
+};
+
 /// <summary>
 /// Initializes a new instance of the <see cref="Accelerometer"/> class.
 /// </summary>
 /// <param name="shield">The shield.</param>
-Accelerometer::Accelerometer(const VirtualShield &shield) : Sensor(shield, 'A') {
-}
-
-/// <summary>
-/// Event called when a valid json message was received. 
-/// Consumes the proper values for this sensor.
-/// </summary>
-/// <param name="root">The root json object.</param>
-/// <param name="shieldEvent">The shield event.</param>
-void Accelerometer::onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) {
-	X = root["X"];
-	Y = root["Y"];
-	Z = root["Z"];
-
-	Sensor::onJsonReceived(root, shieldEvent);
+Accelerometer::Accelerometer(const VirtualShield &shield) : Sensor(shield, 'A', ACCELEROMETER_FIELDS, 3) {
 }
@@ -38,8 +38,6 @@ public:
 	double Z;
 
 	Accelerometer(const VirtualShield &shield);
-
-	void onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) override;
 };
 
 #endif
\ No newline at end of file
@@ -31,9 +31,11 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_CAMERA[] = "CAMERA";
+constexpr PROGMEM char SERVICE_CAMERA[] = "CAMERA";
 const PROGMEM char PREVIEW[] = "PREVIEW";
 
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_CAMERA), "the Camera service name is not in SHIELD_DICTIONARY");
+
 /// <summary>
 /// Initializes a new instance of the <see cref="Camera"/> class.
 /// </summary>
@@ -0,0 +1,362 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "Cbor.h"
+
+extern "C" {
+#include <string.h>
+#include <stdlib.h>
+}
+
+/// <summary>
+/// Writes a CBOR item head using the shortest argument encoding.
+/// </summary>
+/// <param name="out">The output.</param>
+/// <param name="major">The major type.</param>
+/// <param name="value">The argument (value or length).</param>
+void Cbor::writeHead(Print& out, uint8_t major, uint32_t value)
+{
+	uint8_t head[5];
+	uint8_t size = 1;
+	major <<= 5;
+
+	if (value < 24)
+	{
+		head[0] = major | value;
+	}
+	else if (value <= 0xFF)
+	{
+		head[0] = major | 24;
+		head[size++] = value;
+	}
+	else if (value <= 0xFFFF)
+	{
+		head[0] = major | 25;
+		head[size++] = value >> 8;
+		head[size++] = value;
+	}
+	else
+	{
+		head[0] = major | 26;
+		head[size++] = value >> 24;
+		head[size++] = value >> 16;
+		head[size++] = value >> 8;
+		head[size++] = value;
+	}
+
+	out.write(head, size);
+}
+
+/// <summary>
+/// Opens an indefinite-length map, array or string.
+/// </summary>
+void Cbor::writeIndefinite(Print& out, uint8_t major)
+{
+	out.write((uint8_t)((major << 5) | CBOR_INDEFINITE));
+}
+
+/// <summary>
+/// Closes an indefinite-length map, array or string.
+/// </summary>
+void Cbor::writeBreak(Print& out)
+{
+	out.write(CBOR_BREAK);
+}
+
+/// <summary>
+/// Writes a signed integer.
+/// </summary>
+void Cbor::writeInt(Print& out, long value)
+{
+	if (value < 0)
+	{
+		writeHead(out, CBOR_NEGINT, (uint32_t)(-1 - value));
+	}
+	else
+	{
+		writeHead(out, CBOR_UINT, (uint32_t)value);
+	}
+}
+
+/// <summary>
+/// Writes a single precision float (the size of a double on AVR).
+/// </summary>
+void Cbor::writeFloat(Print& out, float value)
+{
+	union
+	{
+		float f;
+		uint32_t bits;
+	} number;
+
+	number.f = value;
+
+	uint8_t item[5] = { CBOR_FLOAT32, (uint8_t)(number.bits >> 24), (uint8_t)(number.bits >> 16), (uint8_t)(number.bits >> 8), (uint8_t)number.bits };
+	out.write(item, 5);
+}
+
+/// <summary>
+/// Writes a boolean.
+/// </summary>
+void Cbor::writeBool(Print& out, bool value)
+{
+	out.write(value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+/// <summary>
+/// Writes a definite text string from memory.
+/// </summary>
+void Cbor::writeText(Print& out, const char* text, size_t length)
+{
+	writeHead(out, CBOR_TEXT, length);
+	out.write(reinterpret_cast<const uint8_t*>(text), length);
+}
+
+/// <summary>
+/// Reads the argument of the item head at the index, advancing the index past the head.
+/// </summary>
+/// <returns>false if the head is malformed or runs past the end.</returns>
+static bool readArgument(const uint8_t* buffer, int length, int& index, uint8_t info, uint32_t& value)
+{
+	if (info < 24)
+	{
+		value = info;
+		return true;
+	}
+
+	int size = info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : 0;
+	if (size == 0 || index + size > length)
+	{
+		return false;
+	}
+
+	value = 0;
+	while (size-- > 0)
+	{
+		value = (value << 8) | buffer[index++];
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Converts the bits of an IEEE 754 double into a float without relying on the size of double.
+/// </summary>
+static float float64ToFloat(const uint8_t* bits)
+{
+	uint32_t high = ((uint32_t)bits[0] << 24) | ((uint32_t)bits[1] << 16) | ((uint32_t)bits[2] << 8) | bits[3];
+	uint32_t low = ((uint32_t)bits[4] << 24) | ((uint32_t)bits[5] << 16) | ((uint32_t)bits[6] << 8) | bits[7];
+
+	uint32_t sign = high & 0x80000000UL;
+	int exponent = (int)((high >> 20) & 0x7FF) - 1023 + 127;
+	uint32_t mantissa = ((high & 0xFFFFF) << 3) | (low >> 29);
+
+	union
+	{
+		float f;
+		uint32_t bits;
+	} number;
+
+	if (exponent <= 0)
+	{
+		number.bits = sign;
+	}
+	else if (exponent >= 0xFF)
+	{
+		number.bits = sign | 0x7F800000UL;
+	}
+	else
+	{
+		number.bits = sign | ((uint32_t)exponent << 23) | mantissa;
+	}
+
+	return number.f;
+}
+
+/// <summary>
+/// Decodes a flat CBOR map in place into a json object.
+/// Text is terminated in place, so the object points into the buffer and no memory is allocated.
+/// </summary>
+/// <param name="buffer">The buffer holding one CBOR map.</param>
+/// <param name="length">The length of the map.</param>
+/// <param name="root">The object to populate.</param>
+/// <returns>true if the whole map was decoded.</returns>
+bool Cbor::decodeObject(char* buffer, int length, JsonObject& root)
+{
+	uint8_t* data = reinterpret_cast<uint8_t*>(buffer);
+	int index = 0;
+	uint32_t pairs = 0;
+
+	if (length < 1 || (data[0] >> 5) != CBOR_MAP)
+	{
+		return false;
+	}
+
+	bool indefinite = (data[0] & 0x1F) == CBOR_INDEFINITE;
+	uint8_t info = data[index++] & 0x1F;
+	if (!indefinite && !readArgument(data, length, index, info, pairs))
+	{
+		return false;
+	}
+
+	const char* key = 0;
+	while (indefinite || pairs > 0 || key)
+	{
+		if (index >= length)
+		{
+			return false;
+		}
+
+		if (indefinite && !key && data[index] == CBOR_BREAK)
+		{
+			return true;
+		}
+
+		int start = index;
+		uint8_t major = data[index] >> 5;
+		uint32_t value;
+		info = data[index++] & 0x1F;
+
+		if (major == CBOR_SIMPLE)
+		{
+			if (!key)
+			{
+				return false;
+			}
+
+			switch (data[start])
+			{
+			case CBOR_FALSE:
+			case CBOR_TRUE:
+				root.set(key, data[start] == CBOR_TRUE);
+				break;
+			case CBOR_NULL:
+				break;
+			case CBOR_FLOAT32:
+				if (index + 4 > length) return false;
+				{
+					union
+					{
+						float f;
+						uint32_t bits;
+					} number;
+
+					number.bits = ((uint32_t)data[index] << 24) | ((uint32_t)data[index + 1] << 16) | ((uint32_t)data[index + 2] << 8) | data[index + 3];
+					root.set(key, (double)number.f);
+				}
+				index += 4;
+				break;
+			case CBOR_FLOAT64:
+				if (index + 8 > length) return false;
+				root.set(key, (double)float64ToFloat(data + index));
+				index += 8;
+				break;
+			default:
+				return false;
+			}
+
+			key = 0;
+			if (!indefinite) pairs--;
+			continue;
+		}
+
+		if (!readArgument(data, length, index, info, value))
+		{
+			return false;
+		}
+
+		switch (major)
+		{
+		case CBOR_UINT:
+		case CBOR_NEGINT:
+			if (!key) return false;
+			root.set(key, major == CBOR_UINT ? (long)value : -1 - (long)value);
+			break;
+		case CBOR_TEXT:
+			if (index + (int)value > length) return false;
+
+			// shift the text over its head to make room for the terminator
+			memmove(buffer + start, buffer + index, value);
+			buffer[start + value] = 0;
+			index += value;
+
+			if (!key)
+			{
+				key = buffer + start;
+				continue;
+			}
+
+			root.set(key, static_cast<const char*>(buffer + start));
+			break;
+		default:
+			// nested containers are not part of an event
+			return false;
+		}
+
+		key = 0;
+		if (!indefinite) pairs--;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Writes a text byte, opening an indefinite string once the text no longer fits a single chunk.
+/// </summary>
+size_t CborText::write(uint8_t c)
+{
+	if (length == sizeof(chunk))
+	{
+		if (!chunked)
+		{
+			Cbor::writeIndefinite(out, CBOR_TEXT);
+			chunked = true;
+		}
+
+		Cbor::writeText(out, chunk, length);
+		length = 0;
+	}
+
+	chunk[length++] = c;
+	return 1;
+}
+
+/// <summary>
+/// Writes out the remaining text and closes the string.
+/// </summary>
+void CborText::end()
+{
+	if (length > 0 || !chunked)
+	{
+		Cbor::writeText(out, chunk, length);
+	}
+
+	if (chunked)
+	{
+		Cbor::writeBreak(out);
+	}
+
+	length = 0;
+	chunked = false;
+}
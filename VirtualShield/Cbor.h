@@ -0,0 +1,85 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef Cbor_h
+#define Cbor_h
+
+#include "Arduino.h"
+
+#include <ArduinoJson.h>
+
+// CBOR (RFC 7049) major types.
+const uint8_t CBOR_UINT = 0;
+const uint8_t CBOR_NEGINT = 1;
+const uint8_t CBOR_TEXT = 3;
+const uint8_t CBOR_ARRAY = 4;
+const uint8_t CBOR_MAP = 5;
+const uint8_t CBOR_SIMPLE = 7;
+
+const uint8_t CBOR_FALSE = 0xF4;
+const uint8_t CBOR_TRUE = 0xF5;
+const uint8_t CBOR_NULL = 0xF6;
+const uint8_t CBOR_FLOAT32 = 0xFA;
+const uint8_t CBOR_FLOAT64 = 0xFB;
+const uint8_t CBOR_INDEFINITE = 0x1F;
+const uint8_t CBOR_BREAK = 0xFF;
+
+// Leads a length-prefixed binary frame sent by the remote device (ASCII record separator).
+const uint8_t BINARY_FRAME_START = 0x1E;
+
+struct Cbor
+{
+	static void writeHead(Print& out, uint8_t major, uint32_t value);
+	static void writeIndefinite(Print& out, uint8_t major);
+	static void writeBreak(Print& out);
+	static void writeInt(Print& out, long value);
+	static void writeFloat(Print& out, float value);
+	static void writeBool(Print& out, bool value);
+	static void writeText(Print& out, const char* text, size_t length);
+
+	static bool decodeObject(char* buffer, int length, JsonObject& root);
+};
+
+/// <summary>
+/// Writes a CBOR text string whose length is not known up front.
+/// Short text is sent as a single definite string; longer text is sent as an indefinite string of chunks.
+/// </summary>
+class CborText : public Print
+{
+public:
+	CborText(Print& out) : out(out) {}
+
+	size_t write(uint8_t c) override;
+	void end();
+
+	using Print::write;
+
+private:
+	Print& out;
+	char chunk[23];
+	uint8_t length = 0;
+	bool chunked = false;
+};
+
+#endif
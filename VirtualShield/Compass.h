@@ -36,8 +36,6 @@ public:
 	double Heading;
 
 	Compass(const VirtualShield &shield);
-
-	void onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) override;
 };
 
 #endif
\ No newline at end of file
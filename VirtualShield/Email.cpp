@@ -29,9 +29,12 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_EMAIL[] = "EMAIL";
-const PROGMEM char SUBJECT[] = "Subject";
-const PROGMEM char CC[] = "Cc";
+constexpr PROGMEM char SERVICE_EMAIL[] = "EMAIL";
+constexpr PROGMEM char SUBJECT[] = "Subject";
+constexpr PROGMEM char CC[] = "Cc";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_EMAIL) && VirtualShield::isDictionaryEntry(SUBJECT) &&
+	VirtualShield::isDictionaryEntry(CC), "an Email key is not in SHIELD_DICTIONARY");
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Email"/> class.
@@ -0,0 +1,423 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "FrameWriter.h"
+
+extern "C" {
+#include <string.h>
+#include <stdlib.h>
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="FrameWriter"/> class.
+/// </summary>
+/// <param name="buffer">The buffer used to assemble a frame.</param>
+/// <param name="capacity">The capacity of the buffer.</param>
+FrameWriter::FrameWriter(char* buffer, int capacity) : buffer(buffer), capacity(capacity)
+{
+}
+
+/// <summary>
+/// Attaches the stream that frames and pass-through writes are sent on.
+/// </summary>
+/// <param name="stream">The stream.</param>
+void FrameWriter::attach(Stream* stream)
+{
+	this->stream = stream;
+	isRoomReported = false;
+}
+
+/// <summary>
+/// Opens a frame. Everything written until end() is assembled in the buffer and sent with a single write.
+/// Bytes of an earlier frame still waiting to be sent (async) are kept ahead of the new frame,
+/// unless the new frame is urgent: it is then sent right after the frame being sent.
+/// </summary>
+/// <param name="stream">The stream the frame is sent on.</param>
+/// <param name="urgent">true to send the frame ahead of queued frames.</param>
+void FrameWriter::begin(Stream* stream, bool urgent)
+{
+	if (this->stream != stream)
+	{
+		drain();
+		isRoomReported = false;
+	}
+
+	if (sent > 0)
+	{
+		memmove(buffer, buffer + sent, length - sent);
+		length -= sent;
+
+		for (int i = 0; i < frameEndCount; i++)
+		{
+			frameEnds[i] -= sent;
+		}
+
+		urgentEnd = urgentEnd > sent ? urgentEnd - sent : 0;
+		sent = 0;
+	}
+	else if (length == 0)
+	{
+		// nothing queued, so the new frame starts on a frame boundary
+		addFrameEnd(0, 0);
+	}
+
+	this->stream = stream;
+	this->urgent = urgent;
+	this->frameStart = length;
+	this->open = true;
+	this->failed = false;
+}
+
+/// <summary>
+/// Closes the frame and sends what remains in the buffer.
+/// When async, only what the stream can take without waiting is sent; pump() sends the rest.
+/// </summary>
+/// <returns>true if every byte sent so far was accepted by the stream.</returns>
+bool FrameWriter::end()
+{
+	this->open = false;
+
+	if (urgent && frameStart > sent)
+	{
+		promote();
+	}
+	else
+	{
+		addFrameEnd(frameEndCount, length);
+	}
+
+	if (async)
+	{
+		pump();
+	}
+	else
+	{
+		drain();
+	}
+
+	return !failed;
+}
+
+/// <summary>
+/// Sends as much of a closed frame as the stream can take without waiting (availableForWrite). A stream that
+/// has never reported room may not implement availableForWrite (SoftwareSerial does not): it is written blocking.
+/// </summary>
+/// <returns>true if nothing remains to be sent.</returns>
+bool FrameWriter::pump()
+{
+	if (open || !stream)
+	{
+		return pending() == 0;
+	}
+
+	int count = stream->availableForWrite();
+	if (count > 0)
+	{
+		isRoomReported = true;
+	}
+	else if (!isRoomReported && pending() > 0)
+	{
+		drain();
+		return true;
+	}
+
+	if (count > pending())
+	{
+		count = pending();
+	}
+
+	if (count > 0)
+	{
+		if (mirror)
+		{
+			mirror->write(reinterpret_cast<const uint8_t*>(buffer + sent), count);
+		}
+
+		if (stream->write(reinterpret_cast<const uint8_t*>(buffer + sent), count) != (size_t)count)
+		{
+			failed = true;
+		}
+
+		sent += count;
+	}
+
+	if (sent == length)
+	{
+		length = sent = frameEndCount = urgentEnd = 0;
+		return true;
+	}
+
+	// forget the ends of frames sent completely
+	int index = 0;
+	while (index < frameEndCount && frameEnds[index] < sent)
+	{
+		index++;
+	}
+
+	if (index > 0)
+	{
+		frameEndCount -= index;
+		memmove(frameEnds, frameEnds + index, frameEndCount * sizeof(int));
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Records the end of a queued frame. When full, the last end is forgotten: the last two frames are then
+/// treated as one, which only places a later urgent frame behind both.
+/// </summary>
+/// <param name="index">The index to insert the end at.</param>
+/// <param name="end">The offset of the end of the frame.</param>
+void FrameWriter::addFrameEnd(int index, int end)
+{
+	if (frameEndCount == maxFrameEnds)
+	{
+		if (index == maxFrameEnds)
+		{
+			return;
+		}
+
+		frameEndCount--;
+	}
+
+	memmove(frameEnds + index + 1, frameEnds + index, (frameEndCount - index) * sizeof(int));
+	frameEnds[index] = end;
+	frameEndCount++;
+}
+
+/// <summary>
+/// Moves the urgent frame just closed ahead of the queued frames: right after the frame being sent,
+/// and after urgent frames queued earlier.
+/// </summary>
+void FrameWriter::promote()
+{
+	int size = length - frameStart;
+	int target = frameStart;
+
+	for (int i = 0; i < frameEndCount; i++)
+	{
+		if (frameEnds[i] >= sent)
+		{
+			target = frameEnds[i];
+			break;
+		}
+	}
+
+	if (urgentEnd > target)
+	{
+		target = urgentEnd;
+	}
+
+	int index = 0;
+	while (index < frameEndCount && frameEnds[index] <= target)
+	{
+		index++;
+	}
+
+	// rotate [target, length) so the frame at its tail comes first
+	char* ranges[3][2] = { { buffer + target, buffer + frameStart }, { buffer + frameStart, buffer + length }, { buffer + target, buffer + length } };
+	for (int i = 0; i < 3; i++)
+	{
+		char* low = ranges[i][0];
+		char* high = ranges[i][1] - 1;
+		while (low < high)
+		{
+			char c = *low;
+			*low++ = *high;
+			*high-- = c;
+		}
+	}
+
+	for (int i = index; i < frameEndCount; i++)
+	{
+		frameEnds[i] += size;
+	}
+
+	urgentEnd = target + size;
+	addFrameEnd(index, urgentEnd);
+}
+
+/// <summary>
+/// Writes a single byte into the open frame, or straight to the stream when no frame is open.
+/// </summary>
+/// <param name="c">The byte.</param>
+/// <returns>The count of bytes written.</returns>
+size_t FrameWriter::write(uint8_t c)
+{
+	if (!open)
+	{
+		drain();
+
+		if (mirror)
+		{
+			mirror->write(c);
+		}
+
+		return stream ? stream->write(c) : 0;
+	}
+
+	if (length == capacity)
+	{
+		// the frame is larger than the buffer - fall back to streaming it out in buffer-sized pieces
+		overflowCount++;
+		drain();
+	}
+
+	if (capture)
+	{
+		capture->write(c);
+	}
+
+	buffer[length++] = c;
+	return 1;
+}
+
+/// <summary>
+/// Writes a block of bytes into the open frame, or straight to the stream when no frame is open.
+/// </summary>
+/// <param name="data">The data.</param>
+/// <param name="size">The size of the data.</param>
+/// <returns>The count of bytes written.</returns>
+size_t FrameWriter::write(const uint8_t* data, size_t size)
+{
+	if (!open)
+	{
+		drain();
+
+		if (mirror)
+		{
+			mirror->write(data, size);
+		}
+
+		return stream ? stream->write(data, size) : 0;
+	}
+
+	size_t remaining = size;
+	while (remaining > 0)
+	{
+		if (length == capacity)
+		{
+			overflowCount++;
+			drain();
+		}
+
+		size_t count = capacity - length;
+		if (count > remaining)
+		{
+			count = remaining;
+		}
+
+		if (capture)
+		{
+			capture->write(data, count);
+		}
+
+		memcpy(buffer + length, data, count);
+		length += count;
+		data += count;
+		remaining -= count;
+	}
+
+	return size;
+}
+
+/// <summary>
+/// Copies a block of a flash (PROGMEM) string into the open frame, or straight to the stream when no frame is open.
+/// </summary>
+/// <param name="flashString">The flash (PROGMEM) string address.</param>
+/// <param name="size">The count of bytes to copy.</param>
+/// <returns>The count of bytes written.</returns>
+size_t FrameWriter::writeFlash(const char* flashString, size_t size)
+{
+	if (!open)
+	{
+		char chunk[16];
+		size_t written = 0;
+		while (written < size)
+		{
+			size_t count = size - written < sizeof(chunk) ? size - written : sizeof(chunk);
+			memcpy_P(chunk, flashString + written, count);
+			write(reinterpret_cast<const uint8_t*>(chunk), count);
+			written += count;
+		}
+
+		return size;
+	}
+
+	size_t remaining = size;
+	while (remaining > 0)
+	{
+		if (length == capacity)
+		{
+			overflowCount++;
+			drain();
+		}
+
+		size_t count = capacity - length;
+		if (count > remaining)
+		{
+			count = remaining;
+		}
+
+		memcpy_P(buffer + length, flashString, count);
+
+		if (capture)
+		{
+			capture->write(reinterpret_cast<const uint8_t*>(buffer + length), count);
+		}
+
+		length += count;
+		flashString += count;
+		remaining -= count;
+	}
+
+	return size;
+}
+
+/// <summary>
+/// Sends the buffered bytes on the stream with a single write, waiting for room if need be.
+/// </summary>
+void FrameWriter::drain()
+{
+	frameStart = frameEndCount = urgentEnd = 0;
+
+	if (pending() == 0)
+	{
+		length = sent = 0;
+		return;
+	}
+
+	if (mirror)
+	{
+		mirror->write(reinterpret_cast<const uint8_t*>(buffer + sent), pending());
+	}
+
+	if (!stream || stream->write(reinterpret_cast<const uint8_t*>(buffer + sent), pending()) != (size_t)pending())
+	{
+		failed = true;
+	}
+
+	length = sent = 0;
+}
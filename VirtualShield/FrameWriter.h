@@ -0,0 +1,84 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef FrameWriter_h
+#define FrameWriter_h
+
+#include "Arduino.h"
+
+// The count of queued frame ends tracked so an urgent frame can be placed between frames.
+const int maxFrameEnds = 4;
+
+class FrameWriter : public Print
+{
+public:
+	Print* mirror = 0;
+	Print* capture = 0;
+	int overflowCount = 0;
+	bool async = false;
+
+	FrameWriter(char* buffer, int capacity);
+
+	void attach(Stream* stream);
+	void begin(Stream* stream, bool urgent = false);
+	bool end();
+	bool pump();
+
+	bool isOpen() const
+	{
+		return open;
+	}
+
+	int pending() const
+	{
+		return length - sent;
+	}
+
+	size_t write(uint8_t c) override;
+	size_t write(const uint8_t* data, size_t size) override;
+	size_t writeFlash(const char* flashString, size_t size);
+
+	using Print::write;
+
+private:
+	Stream* stream = 0;
+	char* buffer;
+	int capacity;
+	int length = 0;
+	int sent = 0;
+	bool open = false;
+	bool failed = false;
+	bool urgent = false;
+	bool isRoomReported = false;
+	int frameStart = 0;
+	int urgentEnd = 0;
+	int frameEnds[maxFrameEnds];
+	int frameEndCount = 0;
+
+	void drain();
+	void addFrameEnd(int index, int end);
+	void promote();
+};
+
+#endif
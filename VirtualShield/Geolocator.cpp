@@ -29,23 +29,20 @@ extern "C" {
 #include <stdlib.h>
 }
 
+const PROGMEM char FIELD_LAT[] = "Lat";
+const PROGMEM char FIELD_LON[] = "Lon";
+const PROGMEM char FIELD_ALT[] = "Alt";
+
+// Fields read from events of this sensor.
+const PROGMEM SensorField GEOLOCATOR_FIELDS[] = {
+	{ FIELD_LAT, static_cast<double Sensor::*>(&Geolocator::Latitude) },
+	{ FIELD_LON, static_cast<double Sensor::*>(&Geolocator::Longitude) },
+	{ FIELD_ALT, static_cast<double Sensor::*>(&Geolocator::Altitude) }
+};
+
 /// <summary>
 /// Initializes a new instance of the <see cref="Geolocator"/> class.
 /// </summary>
 /// <param name="shield">The shield.</param>
-Geolocator::Geolocator(const VirtualShield &shield) : Sensor(shield, 'L') {
-}
-
-/// <summary>
-/// Event called when a valid json message was received. 
-/// Consumes the proper values for this sensor.
-/// </summary>
-/// <param name="root">The root json object.</param>
-/// <param name="shieldEvent">The shield event.</param>
-void Geolocator::onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) {
-	Latitude = root["Lat"];
-	Longitude = root["Lon"];
-	Altitude = root["Alt"];
-
-	Sensor::onJsonReceived(root, shieldEvent);
+Geolocator::Geolocator(const VirtualShield &shield) : Sensor(shield, 'L', GEOLOCATOR_FIELDS, 3) {
 }
@@ -30,22 +30,36 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_NAME_GRAPHICS[] = "LCDG";
-const PROGMEM char X[] = "X";
-const PROGMEM char Y2[] = "Y2";
-const PROGMEM char X2[] = "X2"; 
-const PROGMEM char WIDTH[] = "Width";
-const PROGMEM char HEIGHT[] = "Height"; 
+constexpr PROGMEM char SERVICE_NAME_GRAPHICS[] = "LCDG";
+constexpr PROGMEM char X[] = "X";
+constexpr PROGMEM char Y2[] = "Y2";
+constexpr PROGMEM char X2[] = "X2"; 
+constexpr PROGMEM char WIDTH[] = "Width";
+constexpr PROGMEM char HEIGHT[] = "Height"; 
 const PROGMEM char BUTTON[] = "BUTTON";
 const PROGMEM char RECTANGLE[] = "RECTANGLE";
 const PROGMEM char LINE[] = "LINE";
 const PROGMEM char TEXT[] = "TEXT";
-const PROGMEM char PATH[] = "Path";
+constexpr PROGMEM char PATH[] = "Path";
 const PROGMEM char TOUCH[] = "TOUCH";
 const PROGMEM char ORIENTATION[] = "ORIENTATION";
-const PROGMEM char VALUE[] = "VALUE";
+constexpr PROGMEM char VALUE[] = "VALUE";
 const PROGMEM char INPUTTXT[] = "INPUT";
-const PROGMEM char MULTI[] = "MULTI";
+constexpr PROGMEM char MULTI[] = "MULTI";
+const PROGMEM char PRESSED[] = "pressed";
+const PROGMEM char RELEASED[] = "released";
+const PROGMEM char CLICK[] = "click";
+const PROGMEM char TAPPED[] = "tapped";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_NAME_GRAPHICS) && VirtualShield::isDictionaryEntry(X) &&
+	VirtualShield::isDictionaryEntry(Y2) && VirtualShield::isDictionaryEntry(X2) &&
+	VirtualShield::isDictionaryEntry(WIDTH) && VirtualShield::isDictionaryEntry(HEIGHT) &&
+	VirtualShield::isDictionaryEntry(PATH) && VirtualShield::isDictionaryEntry(VALUE) &&
+	VirtualShield::isDictionaryEntry(MULTI), "a Graphics key is not in SHIELD_DICTIONARY");
+
+// Fixed-shape commands (see VirtualShield::writeShape).
+const PROGMEM Shape LINE_SHAPE = { LINE, 0, { Y, X, X2, Y2 } };
+const PROGMEM Shape RECTANGLE_SHAPE = { RECTANGLE, 0, { Y, X, WIDTH, HEIGHT } };
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Screen"/> class.
@@ -55,13 +69,25 @@ Graphics::Graphics(const VirtualShield &shield) : Text(shield) {
 }
 
 int Graphics::line(UINT x1, UINT y1, UINT x2, UINT y2, ARGB argb, UINT weight)
+{
+	EPtr options[] = { EPtr(RGBAKEY, (uint32_t)argb.color, argb.color ? Uint : None),
+		EPtr(WIDTH, (uint32_t) weight, weight == 1 ? None : Uint) };
+
+	int id = shield.writeShape(SERVICE_NAME_GRAPHICS, &LINE_SHAPE, sensorType, options, 2, y1, x1, x2, y2);
+	return shield.block(id ? id : writeLine(x1, y1, x2, y2, argb, weight), onEvent == 0);
+}
+
+/// <summary>
+/// Writes a line from EPtrs, when it cannot be written from its shape.
+/// </summary>
+int Graphics::writeLine(UINT x1, UINT y1, UINT x2, UINT y2, ARGB argb, UINT weight)
 {
 	EPtr eptrs[] = { EPtr(ACTION, LINE), EPtr(Y, (uint32_t)y1), EPtr(X, (uint32_t)x1),
 		EPtr(X2, (uint32_t)x2), EPtr(Y2, (uint32_t)y2),
 		EPtr(RGBAKEY, (uint32_t)argb.color, argb.color ? Uint : None),
 		EPtr(WIDTH, (uint32_t) weight, weight == 1 ? None : Uint) };
 
-	return shield.block(writeAll(SERVICE_NAME_GRAPHICS, eptrs, 7), onEvent == 0);
+	return writeAll(SERVICE_NAME_GRAPHICS, eptrs, 7);
 }
 
 /// <summary>
@@ -74,7 +100,7 @@ int Graphics::line(UINT x1, UINT y1, UINT x2, UINT y2, ARGB argb, UINT weight)
 int Graphics::drawAt(UINT x, UINT y, String text, ARGB argb)
 {
 	EPtr eptrs[] = { EPtr(ACTION, TEXT), EPtr(Y, (uint32_t)y), EPtr(X, (uint32_t)x), EPtr(MemPtr, MESSAGE, text.c_str()), EPtr(RGBAKEY, (uint32_t)argb.color, (uint32_t)argb.color ? Uint : None) };
-	return writeAll(SERVICE_NAME_GRAPHICS, eptrs, 5);
+	return writeCached(VirtualShield::cacheKey(SERVICE_NAME_GRAPHICS, x, y), SERVICE_NAME_GRAPHICS, eptrs, 5);
 }
 
 /// <summary>
@@ -127,13 +153,26 @@ int Graphics::input(UINT x, UINT y, bool multiline, String text, UINT width, UIN
 /// <param name="tag">The tag. Returned back for event recognition.</param>
 /// <returns>The id of the message. Negative if an error.</returns>
 int Graphics::fillRectangle(UINT x, UINT y, UINT width, UINT height, ARGB argb, String tag)
+{
+	EPtr options[] = { EPtr(RGBAKEY, (uint32_t)argb.color, argb.color ? Uint : None),
+		EPtr(tag ? MemPtr : None, TAG, tag.c_str()) };
+
+	int id = shield.writeCachedShape(VirtualShield::cacheKey(SERVICE_NAME_GRAPHICS, x, y, tag.c_str()), SERVICE_NAME_GRAPHICS,
+		&RECTANGLE_SHAPE, sensorType, options, 2, y, x, width, height);
+	return shield.block(id ? id : writeRectangle(x, y, width, height, argb, tag), onEvent == 0);
+}
+
+/// <summary>
+/// Writes a filled rectangle from EPtrs, when it cannot be written from its shape.
+/// </summary>
+int Graphics::writeRectangle(UINT x, UINT y, UINT width, UINT height, ARGB argb, const String& tag)
 {
 	EPtr eptrs[] = { EPtr(ACTION, RECTANGLE), EPtr(Y, (uint32_t)y), EPtr(X, (uint32_t)x),
 		EPtr(WIDTH, (uint32_t)width), EPtr(HEIGHT, (uint32_t)height),
 		EPtr(RGBAKEY, (uint32_t)argb.color, argb.color ? Uint : None),
 		EPtr(tag ? MemPtr : None, TAG, tag.c_str()) };
 
-	return shield.block(writeAll(SERVICE_NAME_GRAPHICS, eptrs, 7), onEvent == 0);
+	return writeCached(VirtualShield::cacheKey(SERVICE_NAME_GRAPHICS, x, y, tag.c_str()), SERVICE_NAME_GRAPHICS, eptrs, 7);
 }
 
 int Graphics::orientation(int autoRotationPreferences)
@@ -180,7 +219,7 @@ bool Graphics::isPressed(int id, ShieldEvent* shieldEvent)
 		shieldEvent = &recentEvent;
 	}
 
-	return Sensor::isEvent(id, "pressed", shieldEvent) || Sensor::isEvent(id, "click", shieldEvent);
+	return shieldEvent->id == id && (isAction(PRESSED_HASH, PRESSED, shieldEvent) || isAction(CLICK_HASH, CLICK, shieldEvent));
 }
 
 /// <summary>
@@ -196,7 +235,7 @@ bool Graphics::isPressed(String tag, ShieldEvent* shieldEvent)
 		shieldEvent = &recentEvent;
 	}
 
-	return Sensor::isEvent(tag.c_str(), "pressed", shieldEvent) || Sensor::isEvent(tag.c_str(), "click", shieldEvent);
+	return (isAction(PRESSED_HASH, PRESSED, shieldEvent) || isAction(CLICK_HASH, CLICK, shieldEvent)) && isTagged(tag, shieldEvent);
 }
 
 /// <summary>
@@ -212,7 +251,7 @@ bool Graphics::isReleased(int id, ShieldEvent* shieldEvent)
 		shieldEvent = &recentEvent;
 	}
 
-	return Sensor::isEvent(id, "released", shieldEvent) || Sensor::isEvent(id, "click", shieldEvent);
+	return shieldEvent->id == id && (isAction(RELEASED_HASH, RELEASED, shieldEvent) || isAction(CLICK_HASH, CLICK, shieldEvent));
 }
 
 /// <summary>
@@ -228,7 +267,7 @@ bool Graphics::isReleased(String tag, ShieldEvent* shieldEvent)
 		shieldEvent = &recentEvent;
 	}
 
-	return Sensor::isEvent(tag.c_str(), "released", shieldEvent) || Sensor::isEvent(tag.c_str(), "click", shieldEvent);
+	return (isAction(RELEASED_HASH, RELEASED, shieldEvent) || isAction(CLICK_HASH, CLICK, shieldEvent)) && isTagged(tag, shieldEvent);
 }
 
 /// <summary>
@@ -244,7 +283,7 @@ bool Graphics::isButtonClicked(String tag, ShieldEvent* shieldEvent)
 		shieldEvent = &recentEvent;
 	}
 
-	return Sensor::isEvent(tag.c_str(), "click", shieldEvent) || Sensor::isEvent(tag.c_str(), "tapped", shieldEvent);
+	return (isAction(CLICK_HASH, CLICK, shieldEvent) || isAction(TAPPED_HASH, TAPPED, shieldEvent)) && isTagged(tag, shieldEvent);
 }
 
 /// <summary>
@@ -260,7 +299,19 @@ bool Graphics::isButtonClicked(int id, ShieldEvent* shieldEvent)
         shieldEvent = &recentEvent;
     }
 
-    return Sensor::isEvent(id, "click", shieldEvent) || Sensor::isEvent(id, "tapped", shieldEvent);
+    return shieldEvent->id == id && (isAction(CLICK_HASH, CLICK, shieldEvent) || isAction(TAPPED_HASH, TAPPED, shieldEvent));
+}
+
+/// <summary>
+/// Determines whether the specified shield event has the tag, comparing its hash first. Only called once the
+/// action matched.
+/// </summary>
+/// <param name="tag">The tag.</param>
+/// <param name="shieldEvent">The shield event.</param>
+/// <returns>true if tagged</returns>
+bool Graphics::isTagged(const String& tag, ShieldEvent* shieldEvent)
+{
+	return isTag(VirtualShield::hash(tag.c_str()), tag.c_str(), shieldEvent);
 }
 
 /// <summary>
@@ -28,6 +28,12 @@
 #include "Text.h"
 #include "Sensor.h"
 
+// Hashes (VirtualShield::hash) of the actions of touch events.
+#define PRESSED_HASH ("pressed"_vsh)
+#define RELEASED_HASH ("released"_vsh)
+#define CLICK_HASH ("click"_vsh)
+#define TAPPED_HASH ("tapped"_vsh)
+
 const PROGMEM char HorizontalAlignment[] = "HorizontalAlignment";
 const PROGMEM char Foreground[] = "Foreground";
 
@@ -73,6 +79,12 @@ public:
 
 private:
 	const char* area;
+
+	bool isTagged(const String& tag, ShieldEvent* shieldEvent);
+
+	// the EPtr forms of the shaped commands stay out of line, so their arrays are not on the stack of every call
+	__attribute__((noinline)) int writeLine(UINT x1, UINT y1, UINT x2, UINT y2, ARGB argb, UINT weight);
+	__attribute__((noinline)) int writeRectangle(UINT x, UINT y, UINT width, UINT height, ARGB argb, const String& tag);
 };
 
 #endif
\ No newline at end of file
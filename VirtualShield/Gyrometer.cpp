@@ -29,23 +29,20 @@ extern "C" {
 #include <stdlib.h>
 }
 
+const PROGMEM char FIELD_X[] = "X";
+const PROGMEM char FIELD_Y[] = "Y";
+const PROGMEM char FIELD_Z[] = "Z";
+
+// Fields read from events of this sensor.
+const PROGMEM SensorField GYROMETER_FIELDS[] = {
+	{ FIELD_X, static_cast<double Sensor::*>(&Gyrometer::X) },
+	{ FIELD_Y, static_cast<double Sensor::*>(&Gyrometer::Y) },
+	{ FIELD_Z, static_cast<double Sensor::*>(&Gyrometer::Z) }
+};
+
 /// <summary>
 /// Initializes a new instance of the <see cref="Gyrometer"/> class.
 /// </summary>
 /// <param name="shield">The shield.</param>
-Gyrometer::Gyrometer(const VirtualShield &shield) : Sensor(shield, 'G') {
-}
-
-/// <summary>
-/// Event called when a valid json message was received. 
-/// Consumes the proper values for this sensor.
-/// </summary>
-/// <param name="root">The root json object.</param>
-/// <param name="shieldEvent">The shield event.</param>
-void Gyrometer::onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) {
-	X = root["X"];
-	Y = root["Y"];
-	Z = root["Z"];
-
-	Sensor::onJsonReceived(root, shieldEvent);
+Gyrometer::Gyrometer(const VirtualShield &shield) : Sensor(shield, 'G', GYROMETER_FIELDS, 3) {
 }
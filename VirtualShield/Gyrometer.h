@@ -38,8 +38,6 @@ public:
 	double Z;
 
 	Gyrometer(const VirtualShield &shield);
-
-	void onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) override;
 };
 
 #endif
\ No newline at end of file
@@ -36,8 +36,6 @@ public:
 	double Lux;
 
 	LightSensor(const VirtualShield &shield);
-
-	void onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) override;
 };
 
 #endif
\ No newline at end of file
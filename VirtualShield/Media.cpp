@@ -31,7 +31,9 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_PLAY[] = "PLAY";
+constexpr PROGMEM char SERVICE_PLAY[] = "PLAY";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_PLAY), "the Media service name is not in SHIELD_DICTIONARY");
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Camera"/> class.
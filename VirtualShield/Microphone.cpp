@@ -30,9 +30,12 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_MICROPHONE[] = "MICROPHONE";
-const PROGMEM char AUTOPLAY[] = "Autoplay";
-const PROGMEM char KEEP[] = "Keep";
+constexpr PROGMEM char SERVICE_MICROPHONE[] = "MICROPHONE";
+constexpr PROGMEM char AUTOPLAY[] = "Autoplay";
+constexpr PROGMEM char KEEP[] = "Keep";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_MICROPHONE) && VirtualShield::isDictionaryEntry(AUTOPLAY) &&
+	VirtualShield::isDictionaryEntry(KEEP), "a Microphone key is not in SHIELD_DICTIONARY");
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Microphone"/> class.
@@ -30,10 +30,12 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_NOTIFICATION[] = "NOTIFY";
+constexpr PROGMEM char SERVICE_NOTIFICATION[] = "NOTIFY";
 const PROGMEM char TOAST[] = "Toast";
 const PROGMEM char TILE[] = "Tile";
 
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_NOTIFICATION), "the Notification service name is not in SHIELD_DICTIONARY");
+
 /// <summary>
 /// Initializes a new instance of the <see cref="Microphone"/> class.
 /// </summary>
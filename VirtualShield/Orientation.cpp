@@ -29,24 +29,22 @@ extern "C" {
 #include <stdlib.h>
 }
 
+const PROGMEM char FIELD_X[] = "X";
+const PROGMEM char FIELD_Y[] = "Y";
+const PROGMEM char FIELD_Z[] = "Z";
+const PROGMEM char FIELD_W[] = "W";
+
+// Fields read from events of this sensor.
+const PROGMEM SensorField ORIENTATION_FIELDS[] = {
+	{ FIELD_X, static_cast<double Sensor::*>(&Orientation::X) },
+	{ FIELD_Y, static_cast<double Sensor::*>(&Orientation::Y) },
+	{ FIELD_Z, static_cast<double Sensor::*>(&Orientation::Z) },
+	{ FIELD_W, static_cast<double Sensor::*>(&Orientation::W) }
+};
+
 /// <summary>
 /// Initializes a new instance of the <see cref="Orientation"/> class.
 /// </summary>
 /// <param name="shield">The shield.</param>
-Orientation::Orientation(const VirtualShield &shield) : Sensor(shield, 'Q') {
-}
-
-/// <summary>
-/// Event called when a valid json message was received. 
-/// Consumes the proper values for this sensor.
-/// </summary>
-/// <param name="root">The root json object.</param>
-/// <param name="shieldEvent">The shield event.</param>
-void Orientation::onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) {
-	X = root["X"];
-	Y = root["Y"];
-	Z = root["Z"];
-	W = root["W"];
-
-	Sensor::onJsonReceived(root, shieldEvent);
+Orientation::Orientation(const VirtualShield &shield) : Sensor(shield, 'Q', ORIENTATION_FIELDS, 4) {
 }
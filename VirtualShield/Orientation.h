@@ -39,8 +39,6 @@ public:
 	double W;
 
 	Orientation(const VirtualShield &shield);
-
-	void onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) override;
 };
 
 #endif
\ No newline at end of file
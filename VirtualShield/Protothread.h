@@ -0,0 +1,156 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+
+#ifndef Protothread_h
+#define Protothread_h
+
+#include "VirtualShield.h"
+
+// Stackless coroutines (protothreads) for sketches that run several flows at once without blocking loop().
+//
+// A flow is a function taking a Protothread* and returning a ProtothreadState, its body between PT_BEGIN and
+// PT_END. Each wait returns to the caller and resumes at the same line on the next call, so loop() calls
+// shield.checkSensors() and then every flow. Local variables do not survive a wait; keep them static.
+// A switch statement may not contain a wait. Turn auto-blocking off so requests return their id at once.
+//
+//	Protothread blinker;
+//
+//	ProtothreadState blink(Protothread* pt)
+//	{
+//		PT_BEGIN(pt);
+//		while (true)
+//		{
+//			digitalWrite(LED_PIN, !digitalRead(LED_PIN));
+//			PT_DELAY(pt, 500);
+//		}
+//		PT_END(pt);
+//	}
+
+enum ProtothreadState
+{
+	ProtothreadWaiting = 0,
+	ProtothreadYielded = 1,
+	ProtothreadExited = 2,
+	ProtothreadEnded = 3
+};
+
+struct Protothread
+{
+	unsigned int line = 0;
+	unsigned long started = 0;
+	int id = 0;
+	RequestState requestState = RequestUnknown;
+	bool isTimedOut = false;
+	VirtualShield* awaiting = 0;
+
+	/// <summary>
+	/// Determines whether the flow is past its PT_BEGIN and not yet ended.
+	/// </summary>
+	bool isRunning() const { return line != 0; }
+
+	/// <summary>
+	/// Makes the flow start over from PT_BEGIN on its next call. A request it was awaiting is no longer tracked.
+	/// </summary>
+	void restart()
+	{
+		if (awaiting)
+		{
+			awaiting->untrack(id);
+			awaiting = 0;
+		}
+
+		line = 0;
+	}
+};
+
+// A wait falls through into its resume point on purpose.
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define PT_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define PT_FALLTHROUGH
+#endif
+
+#define PT_BEGIN(pt) bool ptYielded = true; (void)ptYielded; switch ((pt)->line) { case 0:
+
+#define PT_END(pt) } (pt)->line = 0; return ProtothreadEnded
+
+// Waits (returns, then resumes here) until the condition is true.
+#define PT_WAIT_UNTIL(pt, condition) \
+	do { (pt)->line = __LINE__; PT_FALLTHROUGH; case __LINE__: if (!(condition)) return ProtothreadWaiting; } while (0)
+
+#define PT_WAIT_WHILE(pt, condition) PT_WAIT_UNTIL(pt, !(condition))
+
+// Gives the other flows a turn.
+#define PT_YIELD(pt) \
+	do { ptYielded = false; (pt)->line = __LINE__; PT_FALLTHROUGH; case __LINE__: if (!ptYielded) return ProtothreadYielded; } while (0)
+
+#define PT_EXIT(pt) do { (pt)->line = 0; return ProtothreadExited; } while (0)
+
+#define PT_RESTART(pt) do { (pt)->line = 0; return ProtothreadWaiting; } while (0)
+
+// Runs a child flow to its end, e.g. PT_SPAWN(pt, &child, speak(&child)).
+#define PT_SPAWN(pt, child, flow) \
+	do { (child)->restart(); PT_WAIT_UNTIL(pt, (flow) >= ProtothreadExited); } while (0)
+
+// Waits the milliseconds.
+#define PT_DELAY(pt, ms) \
+	do { (pt)->started = millis(); PT_WAIT_UNTIL(pt, millis() - (pt)->started >= (unsigned long)(ms)); } while (0)
+
+// Waits until the condition is true or the milliseconds pass; (pt)->isTimedOut tells which.
+// The condition is evaluated again after the wait, so it must not have side effects.
+#define PT_WAIT_UNTIL_TIMEOUT(pt, condition, ms) \
+	do { \
+		(pt)->started = millis(); \
+		PT_WAIT_UNTIL(pt, (condition) || millis() - (pt)->started >= (unsigned long)(ms)); \
+		(pt)->isTimedOut = !(condition); \
+	} while (0)
+
+// Sends nothing; waits for the response to a request already written, e.g.
+// PT_AWAIT_REQUEST(pt, shield, screen.printAt(1, "Hi"), 5000). (pt)->requestState tells how it ended:
+// RequestCompleted, RequestFailed or RequestTimedOut (RequestFailed too if the id could not be tracked: the
+// shield needs an entry of its request table for each flow awaiting a request, see setRequestTable).
+#define PT_AWAIT_REQUEST(pt, shield, requestId, timeout) \
+	do { \
+		(pt)->id = (shield).track((requestId), 0, (timeout)); \
+		(pt)->requestState = (pt)->id > 0 ? RequestPending : RequestFailed; \
+		(pt)->awaiting = (pt)->id > 0 ? &(shield) : 0; \
+		PT_WAIT_UNTIL(pt, (pt)->requestState != RequestPending || \
+			((pt)->requestState = (shield).requestState((pt)->id)) != RequestPending); \
+		(pt)->awaiting = 0; \
+		(pt)->isTimedOut = (pt)->requestState == RequestTimedOut; \
+	} while (0)
+
+// Waits for the next update of the sensor (see Sensor::isUpdated).
+#define PT_AWAIT_UPDATE(pt, sensor) PT_WAIT_UNTIL(pt, (sensor).isUpdated())
+
+// Waits for the next update of the sensor, or the milliseconds; (pt)->isTimedOut tells which.
+#define PT_AWAIT_UPDATE_TIMEOUT(pt, sensor, ms) \
+	do { \
+		(pt)->started = millis(); \
+		PT_WAIT_UNTIL(pt, ((pt)->isTimedOut = millis() - (pt)->started >= (unsigned long)(ms), \
+			(sensor).isUpdated() ? ((pt)->isTimedOut = false, true) : (pt)->isTimedOut)); \
+	} while (0)
+
+#endif
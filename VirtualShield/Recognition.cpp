@@ -30,9 +30,12 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_NAME_RECOGNIZE[] = "RECOGNIZE";
-const PROGMEM char SPEECH_UI[] = "UI";
-const PROGMEM char CONFIDENCE[] = "CONFIDENCE";
+constexpr PROGMEM char SERVICE_NAME_RECOGNIZE[] = "RECOGNIZE";
+constexpr PROGMEM char SPEECH_UI[] = "UI";
+constexpr PROGMEM char CONFIDENCE[] = "CONFIDENCE";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_NAME_RECOGNIZE) &&
+	VirtualShield::isDictionaryEntry(SPEECH_UI) && VirtualShield::isDictionaryEntry(CONFIDENCE), "a Recognition key is not in SHIELD_DICTIONARY");
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Speech"/> class.
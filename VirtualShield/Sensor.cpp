@@ -29,17 +29,31 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_SENSORS[] = "SENSORS";
-const PROGMEM char SENSORS[] = "Sensors";
-const PROGMEM char DELTA[] = "Delta";
-const PROGMEM char INTERVAL[] = "Interval";
+constexpr PROGMEM char SERVICE_SENSORS[] = "SENSORS";
+constexpr PROGMEM char SENSORS[] = "Sensors";
+constexpr PROGMEM char DELTA[] = "Delta";
+constexpr PROGMEM char INTERVAL[] = "Interval";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_SENSORS) && VirtualShield::isDictionaryEntry(SENSORS) &&
+	VirtualShield::isDictionaryEntry(DELTA) && VirtualShield::isDictionaryEntry(INTERVAL) &&
+	VirtualShield::isDictionaryEntry(MESSAGE) && VirtualShield::isDictionaryEntry(MS) &&
+	VirtualShield::isDictionaryEntry(TO) && VirtualShield::isDictionaryEntry(ATTACHMENT) &&
+	VirtualShield::isDictionaryEntry(ACTION) && VirtualShield::isDictionaryEntry(TAG) &&
+	VirtualShield::isDictionaryEntry(IMAGE) && VirtualShield::isDictionaryEntry(AUDIO) &&
+	VirtualShield::isDictionaryEntry(URL), "a Sensor key is not in SHIELD_DICTIONARY");
+
+// Fixed-shape commands (see VirtualShield::writeShape).
+const PROGMEM Shape SENSOR_SHAPE = { 0, SENSORS, { 0, DELTA, INTERVAL } };
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Sensor"/> class.
 /// </summary>
 /// <param name="shield">The shield.</param>
 /// <param name="sensorType">Filter for identifying a service.</param>
-Sensor::Sensor(const VirtualShield &shield, const char sensorType) : shield(*const_cast<VirtualShield *>(&shield)), sensorType(sensorType) {
+/// <param name="fields">The flash (PROGMEM) schema of numeric fields read from events.</param>
+/// <param name="fieldCount">The count of fields.</param>
+Sensor::Sensor(const VirtualShield &shield, const char sensorType, const SensorField* fields, int fieldCount) :
+	shield(*const_cast<VirtualShield *>(&shield)), sensorType(sensorType), fields(fields), fieldCount(fieldCount) {
 	this->shield.addSensor(this);
 }
 
@@ -89,12 +103,8 @@ int Sensor::getOnChange(double delta)
 /// </summary>
 /// <param name="root">The root json object.</param>
 /// <param name="shieldEvent">The shield event.</param>
-void Sensor::onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) {
-	recentEvent.tag = root["Tag"];
-	recentEvent.action = root["Action"];
-	recentEvent.id = root["Id"];
-	recentEvent.resultId = root["ResultId"];
-	recentEvent.result = root["Result"];
+void Sensor::onJsonReceived(JsonObject& /*root*/, ShieldEvent* shieldEvent) {
+	// recentEvent and the schema fields were filled by the shield in its single pass over root
 	shieldEvent = &recentEvent;
 
 	this->_isUpdated = true;
@@ -105,6 +115,28 @@ void Sensor::onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) {
 	}
 }
 
+/// <summary>
+/// Fills the schema field matching the key, if any.
+/// </summary>
+/// <param name="key">The key.</param>
+/// <param name="value">The value.</param>
+/// <returns>true if the key is a field of this sensor.</returns>
+bool Sensor::readField(const char* key, const JsonVariant& value) {
+	for (int i = 0; i < fieldCount; i++)
+	{
+		SensorField field;
+		memcpy_P(&field, fields + i, sizeof(field));
+
+		if (strcmp_P(key, field.key) == 0)
+		{
+			this->*field.member = value.as<double>();
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /// <summary>
 /// Determines whether this sensor has an updated value. Resets to false after this call.
 /// </summary>
@@ -119,14 +151,14 @@ bool Sensor::isUpdated() {
 }
 
 /// <summary>
-/// Determines whether the specified shieldEvent matches the tag and action.
+/// Determines whether the specified shieldEvent matches the tag and action, comparing their hashes first.
 /// </summary>
 /// <param name="tag">The tag.</param>
 /// <param name="action">The action.</param>
 /// <param name="shieldEvent">The shield event.</param>
 /// <returns>bool.</returns>
 bool Sensor::isEvent(const char* tag, const char* action, ShieldEvent* shieldEvent) {
-	return strcmp(shieldEvent->tag, tag) == 0 && strcmp(shieldEvent->action, action) == 0;
+	return hasAction(action, shieldEvent) && isTag(VirtualShield::hash(tag), tag, shieldEvent);
 }
 
 /// <summary>
@@ -137,7 +169,44 @@ bool Sensor::isEvent(const char* tag, const char* action, ShieldEvent* shieldEve
 /// <param name="shieldEvent">The shield event.</param>
 /// <returns>bool.</returns>
 bool Sensor::isEvent(int id, const char* action, ShieldEvent* shieldEvent) {
-	return shieldEvent->id == id && strcmp(shieldEvent->action, action) == 0;
+	return shieldEvent->id == id && hasAction(action, shieldEvent);
+}
+
+/// <summary>
+/// Determines whether the specified shieldEvent has the action, comparing its hash first (see isAction()).
+/// </summary>
+/// <param name="action">The action.</param>
+/// <param name="shieldEvent">The shield event.</param>
+/// <returns>bool.</returns>
+bool Sensor::hasAction(const char* action, ShieldEvent* shieldEvent) {
+	return shieldEvent->actionHash == VirtualShield::hash(action) &&
+		shieldEvent->action && action && strcmp(shieldEvent->action, action) == 0;
+}
+
+/// <summary>
+/// Determines whether the specified shieldEvent has the action, comparing its hash first.
+/// The text is only compared when the hashes match, to rule out a collision.
+/// </summary>
+/// <param name="actionHash">The hash of the action (see VirtualShield::hash).</param>
+/// <param name="action">The flash (PROGMEM) action.</param>
+/// <param name="shieldEvent">The shield event.</param>
+/// <returns>bool.</returns>
+bool Sensor::isAction(unsigned int actionHash, const char* action, ShieldEvent* shieldEvent) {
+	return shieldEvent->actionHash == actionHash &&
+		shieldEvent->action && strcmp_P(shieldEvent->action, action) == 0;
+}
+
+/// <summary>
+/// Determines whether the specified shieldEvent has the tag, comparing its hash first.
+/// The text is only compared when the hashes match, to rule out a collision.
+/// </summary>
+/// <param name="tagHash">The hash of the tag (see VirtualShield::hash).</param>
+/// <param name="tag">The tag.</param>
+/// <param name="shieldEvent">The shield event.</param>
+/// <returns>bool.</returns>
+bool Sensor::isTag(unsigned int tagHash, const char* tag, ShieldEvent* shieldEvent) {
+	return shieldEvent->tagHash == tagHash &&
+		shieldEvent->tag && tag && strcmp(shieldEvent->tag, tag) == 0;
 }
 
 /// <summary>
@@ -152,19 +221,22 @@ int Sensor::writeAll(const char* serviceName, EPtr values[], int count, Attr ext
 }
 
 /// <summary>
-/// Sends the specific action to start/stop/get/onChange the sensor using a delta and interval.
+/// Writes all EPtr values to the communication channel, skipping a repeat of the last message for the cache key
+/// when the shield's output cache is enabled.
 /// </summary>
-/// <param name="sensorAction">The sensor action.</param>
-/// <param name="delta">The delta.</param>
-/// <param name="interval">The interval.</param>
-/// <returns>int.</returns>
-int Sensor::sensorAction(SensorAction sensorAction, double delta, long interval) const {
-#ifdef debugSerial
-	if (sensorAction > 0)
-	{
-		Serial.print("starting...");
-	}
-#endif
+/// <param name="cacheKey">The cache key.</param>
+/// <param name="serviceName">Name of the service.</param>
+/// <param name="values">The values.</param>
+/// <param name="count">The count of values.</param>
+/// <returns>The id of the message or a negative error.</returns>
+int Sensor::writeCached(unsigned int cacheKey, const char* serviceName, EPtr values[], int count, Attr extraAttributes[], int extraAttributeCount) {
+	return shield.writeCached(cacheKey, serviceName, values, count, extraAttributes, extraAttributeCount, this->sensorType);
+}
+
+/// <summary>
+/// Writes a sensor request from EPtrs, when it cannot be written from its shape.
+/// </summary>
+int Sensor::writeSensorAction(SensorAction sensorAction, double delta, long interval) const {
 	const char sensorTypeSet[2] = { sensorType, 0 };
 
 	EPtr eptr2 = EPtr(sensorTypeSet, static_cast<int>(sensorAction));
@@ -180,7 +252,33 @@ int Sensor::sensorAction(SensorAction sensorAction, double delta, long interval)
 		EPtr(ArrayEnd)
 	};
 
-	int id = this->shield.writeAll(SERVICE_SENSORS, eptrs, 5);
+	return this->shield.writeAll(SERVICE_SENSORS, eptrs, 5);
+}
+
+/// <summary>
+/// Sends the specific action to start/stop/get/onChange the sensor using a delta and interval.
+/// </summary>
+/// <param name="sensorAction">The sensor action.</param>
+/// <param name="delta">The delta.</param>
+/// <param name="interval">The interval.</param>
+/// <returns>int.</returns>
+int Sensor::sensorAction(SensorAction sensorAction, double delta, long interval) const {
+#ifdef debugSerial
+	if (sensorAction > 0)
+	{
+		Serial.print("starting...");
+	}
+#endif
+	// the common start/stop/get requests go out as fixed shapes
+	int id = delta > 0 && interval > 0 ?
+		shield.writeShape(SERVICE_SENSORS, &SENSOR_SHAPE, sensorType, 0, 0, static_cast<int>(sensorAction), delta, interval) :
+		delta <= 0 && interval <= 0 ?
+		shield.writeShape(SERVICE_SENSORS, &SENSOR_SHAPE, sensorType, 0, 0, static_cast<int>(sensorAction)) : 0;
+
+	if (id == 0)
+	{
+		id = writeSensorAction(sensorAction, delta, interval);
+	}
 
 #ifdef debugSerial
 	if (sensorAction < 2)
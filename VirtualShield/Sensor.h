@@ -34,23 +34,31 @@
 #include "Attr.h"
 
 class VirtualShield;
+class Sensor;
 
-const PROGMEM char MESSAGE[] = "Message";
-const PROGMEM char MS[] = "Ms";
-const PROGMEM char TO[] = "To";
-const PROGMEM char ATTACHMENT[] = "Attachment";
+// A numeric field of a sensor, filled from the event key of the same name.
+struct SensorField
+{
+	const char* key;
+	double Sensor::* member;
+};
+
+constexpr PROGMEM char MESSAGE[] = "Message";
+constexpr PROGMEM char MS[] = "Ms";
+constexpr PROGMEM char TO[] = "To";
+constexpr PROGMEM char ATTACHMENT[] = "Attachment";
 const PROGMEM char ENABLE[] = "ENABLE";
 const PROGMEM char DISABLE[] = "DISABLE";
-const PROGMEM char ACTION[] = "Action";
-const PROGMEM char TAG[] = "Tag";
-const PROGMEM char IMAGE[] = "IMAGE";
-const PROGMEM char AUDIO[] = "Audio";
-const PROGMEM char URL[] = "Url";
+constexpr PROGMEM char ACTION[] = "Action";
+constexpr PROGMEM char TAG[] = "Tag";
+constexpr PROGMEM char IMAGE[] = "IMAGE";
+constexpr PROGMEM char AUDIO[] = "Audio";
+constexpr PROGMEM char URL[] = "Url";
 const PROGMEM char STOP[] = "STOP";
 
 class Sensor {
 public:
-	void(*onEvent)(ShieldEvent* shieldEvent);
+	void(*onEvent)(ShieldEvent* shieldEvent) = 0;
 
 	VirtualShield& shield;
 	ShieldEvent recentEvent;
@@ -58,7 +66,10 @@ public:
 	const char sensorType;
 	bool isRunning = false;
 
-	Sensor(const VirtualShield &shield, const char sensorType);
+	// the next sensor of the same type (see VirtualShield::addSensor)
+	Sensor* nextSensor = 0;
+
+	Sensor(const VirtualShield &shield, const char sensorType, const SensorField* fields = 0, int fieldCount = 0);
 
 	int start(double delta = 0, long interval = 0);
 	virtual int stop();
@@ -68,10 +79,14 @@ public:
 	bool isUpdated();
 
 	int writeAll(const char* serviceName, EPtr values[], int count, Attr extraAttributes[] = 0, int extraAttributeCount = 0);
+	int writeCached(unsigned int cacheKey, const char* serviceName, EPtr values[], int count, Attr extraAttributes[] = 0, int extraAttributeCount = 0);
 	int sensorAction(SensorAction sensorAction, double delta = 0, long interval = 0) const;
 
 	virtual bool isEvent(const char* tag, const char* action, ShieldEvent* shieldEvent);
 	virtual bool isEvent(int id, const char* action, ShieldEvent* shieldEvent);
+	bool isAction(unsigned int actionHash, const char* action, ShieldEvent* shieldEvent);
+	bool isTag(unsigned int tagHash, const char* tag, ShieldEvent* shieldEvent);
+	bool hasAction(const char* action, ShieldEvent* shieldEvent);
 
 	void setOnEvent(void(*onEvent)(ShieldEvent* shieldEvent))
 	{
@@ -81,9 +96,15 @@ public:
 	int sendStop(const char* serviceName);
 
 	virtual void onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent);
+	bool readField(const char* key, const JsonVariant& value);
 
 protected:
 	bool _isUpdated = false;
+	const SensorField* fields;
+	int fieldCount;
+
+private:
+	__attribute__((noinline)) int writeSensorAction(SensorAction sensorAction, double delta, long interval) const;
 };
 
 struct SensorEvent : ShieldEvent {
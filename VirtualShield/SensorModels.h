@@ -50,7 +50,8 @@ enum EPtrType
 	ArrayEnd = 10,
 	ValueOnly = 11,
 	Format = 12,
-	Parse = 13
+	Parse = 13,
+	Fixed = 14
 };
 
 union ARGB
@@ -62,12 +63,12 @@ union ARGB
 	};
 
 	ARGB(byte alpha, byte red, byte green, byte blue) :
-		red(red), green(green), blue(blue), alpha(alpha)
+		blue(blue), green(green), red(red), alpha(alpha)
 	{
 	}
 
 	ARGB(byte red, byte green, byte blue) :
-		red(red), green(green), blue(blue), alpha(0)
+		blue(blue), green(green), red(red), alpha(0)
 	{
 	}
 
@@ -82,10 +83,10 @@ union ARGB
 	void hex(char* hexSource)
 	{
 		char hex[9] =
-		{ alpha >> 4, alpha & 0x0F,
-		  red >> 4, red & 0x0F,
-		  green >> 4, green & 0x0F,
-		  blue >> 4, blue & 0x0F };
+		{ static_cast<char>(alpha >> 4), static_cast<char>(alpha & 0x0F),
+		  static_cast<char>(red >> 4), static_cast<char>(red & 0x0F),
+		  static_cast<char>(green >> 4), static_cast<char>(green & 0x0F),
+		  static_cast<char>(blue >> 4), static_cast<char>(blue & 0x0F) };
 
 		for (int i = 0; i < 8; i++)
 		{
@@ -136,7 +137,7 @@ struct EPtr
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
 	/// </summary>
 	/// <param name="ptrType">Type of the EPtr.</param>
-	EPtr(EPtrType ptrType, const char* key, EPtr* eptrs, int len) : ptrType(ptrType), key(key), intValue(len), eptrs(eptrs), asText(true) {}
+	EPtr(EPtrType ptrType, const char* key, EPtr* eptrs, int len) : ptrType(ptrType), key(key), intValue(len), asText(true), eptrs(eptrs) {}
 
 	/// <summary>
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
@@ -151,21 +152,21 @@ struct EPtr
 	/// <param name="ptrType">Type of the PTR.</param>
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
-	EPtr(EPtrType ptrType, const char* key, const char* value) : ptrType(ptrType), key(key), value(value), asText(true), length(-1) {}
+	EPtr(EPtrType ptrType, const char* key, const char* value) : ptrType(ptrType), key(key), value(value), length(-1), asText(true) {}
 
 	/// <summary>
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
 	/// </summary>
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
-	EPtr(const char* key, const char* value) : key(key), value(value), asText(true), ptrType(ProgPtr) {}
+	EPtr(const char* key, const char* value) : ptrType(ProgPtr), key(key), value(value), asText(true) {}
 
 	/// <summary>
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
 	/// </summary>
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
-	EPtr(const char* key, String value) : key(key), asText(true), ptrType(value ? MemPtr : None), length(-1)
+	EPtr(const char* key, String value) : ptrType(value ? MemPtr : None), key(key), length(-1), asText(true)
 	{
 		this->value = value.c_str();
 	}
@@ -175,7 +176,7 @@ struct EPtr
 	/// </summary>
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
-	EPtr(const char* key, const char value) : key(key), asText(true), ptrType(value ? Char : None), charValue(value) {}
+	EPtr(const char* key, const char value) : ptrType(value ? Char : None), key(key), charValue(value), asText(true) {}
 
 	/// <summary>
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
@@ -183,7 +184,7 @@ struct EPtr
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
 	/// <param name="ptrType">Type of the EPtr.</param>
-	EPtr(const char* key, int value, EPtrType ptrType = Int) : key(key), intValue(value), ptrType(ptrType) {}
+	EPtr(const char* key, int value, EPtrType ptrType = Int) : ptrType(ptrType), key(key), intValue(value) {}
 	
 	/// <summary>
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
@@ -191,32 +192,42 @@ struct EPtr
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
 	/// <param name="ptrType">Type of the EPtr.</param>
-	EPtr(const char* key, uint32_t value, EPtrType ptrType = Uint) : key(key), uintValue(value), ptrType(ptrType) {}
+	EPtr(const char* key, uint32_t value, EPtrType ptrType = Uint) : ptrType(ptrType), key(key), uintValue(value) {}
 
 	/// <summary>
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
 	/// </summary>
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
-	/// <param name="ptrType">Type of the EPtr.</param>
-	EPtr(const char* key, long value, EPtrType ptrType = Long) : key(key), longValue(value), ptrType(ptrType) {}
+	/// <param name="ptrType">Type of the EPtr. Fixed sends the value scaled down by 10^decimals (i.e. milli-units with 3).</param>
+	/// <param name="decimals">The count of decimals of a Fixed value. Text keeps at most 6; more are rounded off.</param>
+	EPtr(const char* key, long value, EPtrType ptrType = Long, int decimals = 0) : ptrType(ptrType), key(key), longValue(value), length(decimals) {}
+
+	/// <summary>
+	/// Initializes a new instance of the <see cref="EPtr"/> struct.
+	/// </summary>
+	/// <param name="key">The key.</param>
+	/// <param name="value">The value.</param>
+	/// <param name="asText">As text.</param>
+	EPtr(const char* key, double value, bool asText = false) : ptrType(Double), key(key), doubleValue(value), length(-1), asText(asText) {}
 
 	/// <summary>
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
 	/// </summary>
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
+	/// <param name="precision">The most decimals to send; trailing zeros are dropped.</param>
 	/// <param name="asText">As text.</param>
-	EPtr(const char* key, double value, bool asText = false) : key(key), doubleValue(value), asText(asText), ptrType(Double) {}
+	EPtr(const char* key, double value, int precision, bool asText = false) : ptrType(Double), key(key), doubleValue(value), length(precision), asText(asText) {}
 
 	/// <summary>
 	/// Initializes a new instance of the <see cref="EPtr"/> struct.
 	/// </summary>
 	/// <param name="key">The key.</param>
 	/// <param name="value">The value.</param>
-	EPtr(const char* key, bool value) : key(key), boolValue(value), ptrType(Bool) {}
+	EPtr(const char* key, bool value) : ptrType(Bool), key(key), boolValue(value) {}
 
-	EPtr(const char* key, const char* value, int length) : key(key), value(value), ptrType(MemPtr), length(length) {}
+	EPtr(const char* key, const char* value, int length) : ptrType(MemPtr), key(key), value(value), length(length) {}
 
 	static int parse(const char* text, EPtr* eptrs, int length, const char separator = '|', int eptrStartIndex = 0)
 	{
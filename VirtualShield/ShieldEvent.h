@@ -37,10 +37,11 @@ struct ShieldEvent {
 	int id;
 	long resultId;
 	const char *result;
-	int resultHash;
+	unsigned int resultHash;
 	const char* tag;
+	unsigned int tagHash;
 	const char* action;
-	int actionHash;
+	unsigned int actionHash;
 	void* cargo;
 	double value;
 };
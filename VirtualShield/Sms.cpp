@@ -29,9 +29,12 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_SMS[] = "SMS";
-const PROGMEM char SUBJECT[] = "Subject";
-const PROGMEM char CC[] = "Cc";
+constexpr PROGMEM char SERVICE_SMS[] = "SMS";
+constexpr PROGMEM char SUBJECT[] = "Subject";
+constexpr PROGMEM char CC[] = "Cc";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_SMS) && VirtualShield::isDictionaryEntry(SUBJECT) &&
+	VirtualShield::isDictionaryEntry(CC), "an Sms key is not in SHIELD_DICTIONARY");
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Sms"/> class.
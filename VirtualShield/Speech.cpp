@@ -30,9 +30,11 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_NAME_SPEECH[] = "SPEECH";
+constexpr PROGMEM char SERVICE_NAME_SPEECH[] = "SPEECH";
 const int MEDIA_PAUSED = 4;
 
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_NAME_SPEECH), "the Speech service name is not in SHIELD_DICTIONARY");
+
 /// <summary>
 /// Initializes a new instance of the <see cref="Speech"/> class.
 /// </summary>
@@ -30,8 +30,13 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_NAME_LCDTEXT[] = "LCDT";
+constexpr PROGMEM char SERVICE_NAME_LCDTEXT[] = "LCDT";
 
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_NAME_LCDTEXT) && VirtualShield::isDictionaryEntry(Y) &&
+	VirtualShield::isDictionaryEntry(RGBAKEY) && VirtualShield::isDictionaryEntry(PID), "a Text key is not in SHIELD_DICTIONARY");
+
+// Fixed-shape commands (see VirtualShield::writeShape).
+const PROGMEM Shape PRINT_SHAPE = { 0, 0, { Y, MESSAGE } };
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Screen"/> class.
@@ -47,6 +52,7 @@ Text::Text(const VirtualShield &shield) : Sensor(shield, 'S') {
 int Text::clear(ARGB argb)
 {
 	EPtr eptrs[] = { EPtr(ACTION, CLEAR), EPtr(RGBAKEY, (uint32_t)argb.color, (uint32_t) argb.color ? Uint : None) };
+	shield.clearOutputCache();
 	return writeAll(SERVICE_NAME_LCDTEXT, eptrs, 2);
 }
 
@@ -58,6 +64,7 @@ int Text::clear(ARGB argb)
 int Text::clearLine(UINT line)
 {
 	EPtr eptrs[] = { EPtr(ACTION, CLEAR), EPtr(Y, (uint32_t) line) };
+	shield.clearOutputCache();
     return writeAll(SERVICE_NAME_LCDTEXT, eptrs, 2);
 }
 
@@ -69,6 +76,7 @@ int Text::clearLine(UINT line)
 int Text::clearId(UINT id)
 {
 	EPtr eptrs[] = { EPtr(ACTION, CLEAR), EPtr(PID, (uint32_t) id) };
+	shield.clearOutputCache();
     return writeAll(SERVICE_NAME_LCDTEXT, eptrs, 2);
 }
 
@@ -90,9 +98,21 @@ int Text::print(String text, ARGB argb)
 /// <param name="value">The value.</param>
 /// <returns>The id of the message. Negative if an error.</returns>
 int Text::printAt(UINT line, double value, ARGB argb)
+{
+	EPtr options[] = { EPtr(RGBAKEY, (uint32_t)argb.color, (uint32_t)argb.color ? Uint : None) };
+
+	int id = shield.writeCachedShape(VirtualShield::cacheKey(SERVICE_NAME_LCDTEXT, 0, line), SERVICE_NAME_LCDTEXT,
+		&PRINT_SHAPE, sensorType, options, 1, line, value);
+	return id ? id : writePrintAt(line, value, argb);
+}
+
+/// <summary>
+/// Writes a number at a line from EPtrs, when it cannot be written from its shape.
+/// </summary>
+int Text::writePrintAt(UINT line, double value, ARGB argb)
 {
 	EPtr eptrs[] = { EPtr(Y, (uint32_t)line), EPtr(MESSAGE, value), EPtr(RGBAKEY, (uint32_t)argb.color, (uint32_t)argb.color ? Uint : None) };
-	return writeAll(SERVICE_NAME_LCDTEXT, eptrs, 3);
+	return writeCached(VirtualShield::cacheKey(SERVICE_NAME_LCDTEXT, 0, line), SERVICE_NAME_LCDTEXT, eptrs, 3);
 }
 
 /// <summary>
@@ -102,7 +122,9 @@ int Text::printAt(UINT line, double value, ARGB argb)
 /// <param name="text">The text.</param>
 /// <returns>The id of the message. Negative if an error.</returns>
 int Text::printAt(UINT line, String text, Attr extraAttributes[], int extraAttributeCount) {
-	return printAt(line, EPtr(MemPtr, MESSAGE, text.c_str()), extraAttributes, extraAttributeCount);
+	int id = shield.writeCachedShape(VirtualShield::cacheKey(SERVICE_NAME_LCDTEXT, 0, line), SERVICE_NAME_LCDTEXT,
+		&PRINT_SHAPE, sensorType, extraAttributes, extraAttributeCount, line, text.c_str());
+	return id ? id : printAt(line, EPtr(MemPtr, MESSAGE, text.c_str()), extraAttributes, extraAttributeCount);
 }
 
 /// <summary>
@@ -113,7 +135,7 @@ int Text::printAt(UINT line, String text, Attr extraAttributes[], int extraAttri
 /// <returns>The id of the message. Negative if an error.</returns>
 int Text::printAt(UINT line, EPtr text, Attr extraAttributes[], int extraAttributeCount) {
 	EPtr eptrs[] = { EPtr(Y, (uint32_t) line), text };
-	return writeAll(SERVICE_NAME_LCDTEXT, eptrs, 2, extraAttributes, extraAttributeCount);
+	return writeCached(VirtualShield::cacheKey(SERVICE_NAME_LCDTEXT, 0, line), SERVICE_NAME_LCDTEXT, eptrs, 2, extraAttributes, extraAttributeCount);
 }
 
 /// <summary>
@@ -27,10 +27,10 @@
 
 #include "Sensor.h"
 
-const PROGMEM char Y[] = "Y";
+constexpr PROGMEM char Y[] = "Y";
 const PROGMEM char CLEAR[] = "CLEAR";
-const PROGMEM char RGBAKEY[] = "ARGB";
-const PROGMEM char PID[] = "Pid";
+constexpr PROGMEM char RGBAKEY[] = "ARGB";
+constexpr PROGMEM char PID[] = "Pid";
 
 class Text : public Sensor
 {
@@ -43,10 +43,13 @@ public:
 
 	int print(String text, ARGB argb = 0);
 	int printAt(UINT line, String text, Attr extraAttributes[] = 0, int extraAttributeCount = 0);
-	int printAt(UINT line, EPtr text, Attr extraAttributes[] = 0, int extraAttributeCount = 0);
+	__attribute__((noinline)) int printAt(UINT line, EPtr text, Attr extraAttributes[] = 0, int extraAttributeCount = 0);
 	int printAt(UINT line, double value, ARGB argb = 0);
 
 	void onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) override;
+
+private:
+	__attribute__((noinline)) int writePrintAt(UINT line, double value, ARGB argb);
 };
 
 #endif
\ No newline at end of file
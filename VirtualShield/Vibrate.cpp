@@ -29,7 +29,9 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_VIBRATE[] = "VIBRATE";
+constexpr PROGMEM char SERVICE_VIBRATE[] = "VIBRATE";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_VIBRATE), "the Vibrate service name is not in SHIELD_DICTIONARY");
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Vibrate"/> class.
@@ -30,6 +30,8 @@ extern "C" {
 }
   
 #include "SensorModels.h"
+#include "FrameWriter.h"
+#include "Cbor.h"
 #include <ArduinoJson.h>
 
 // Define the serial port that is used to talk to the virtual shield.
@@ -61,32 +63,382 @@ const PROGMEM char ARRAY_START[] = "[{";
 const PROGMEM char ARRAY_END[] = "}]";
 const PROGMEM char NONTEXT_END[] = "}";
 const PROGMEM char MESSAGE_END[] = "'}";
-const PROGMEM char SERVICE_NAME_SERVICE[] = "SYSTEM";
+constexpr PROGMEM char SERVICE_NAME_SERVICE[] = "SYSTEM";
 const PROGMEM char PONG[] = "PONG";
-const PROGMEM char TYPE[] = "TYPE";
+constexpr PROGMEM char TYPE[] = "TYPE";
 const PROGMEM char START[] = "START";
 const PROGMEM char LEN[] = "LEN";
+const PROGMEM char CODEC_KEY[] = "Codec";
+const PROGMEM char CODEC_CBOR[] = "CBOR";
+constexpr PROGMEM char SERVICE_KEY[] = "Service";
+constexpr PROGMEM char ID_KEY[] = "Id";
+const PROGMEM char DICTIONARY_KEY[] = "Dict";
+constexpr PROGMEM char SERVICE_NAME_BATCH[] = "BATCH";
+constexpr PROGMEM char BATCH_KEY[] = "Batch";
+const PROGMEM char BATCH_START[] = ",'Batch':[";
+const PROGMEM char BATCH_END[] = "]}";
+const PROGMEM char CHUNK_KEY[] = "Chunk";
+const PROGMEM char CHECKSUM_KEY[] = "Crc";
+
+// Keys sent as dictionary tokens are constexpr, so each file can check their entries when compiling.
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_NAME_SERVICE) && VirtualShield::isDictionaryEntry(TYPE) &&
+	VirtualShield::isDictionaryEntry(SERVICE_KEY) && VirtualShield::isDictionaryEntry(ID_KEY) &&
+	VirtualShield::isDictionaryEntry(SERVICE_NAME_BATCH) && VirtualShield::isDictionaryEntry(BATCH_KEY), "a system key is not in SHIELD_DICTIONARY");
+
+const PROGMEM char DICTIONARY[] = SHIELD_DICTIONARY;
+const PROGMEM char DICTIONARY_ACTION[] = "DICT";
+
+const int tokenCacheSize = 8;
+const char* tokenCacheKeys[tokenCacheSize];
+int8_t tokenCacheValues[tokenCacheSize];
 
 const char AWAITING_MESSAGE[] = "{}";
 const char SYSTEM_EVENT = '!';
 
 const int requestInterval = 1000;
 const int perMessageInterval = 25;
-const int maxRememberedSensors = 10;
+
+// The write buffer: a message up to this long goes out in one write, a longer one in pieces of this size.
+// Async sending (see enableAsyncSend) queues messages in it too. The default keeps SRAM low rather than fitting
+// every command: short ones such as printAt (about 60 bytes) go out in one write, while fillRectangle (113), line
+// (101), addButton (94) or Web::get (87) take two. 128 sends those whole for 64 more bytes of SRAM; a smaller
+// buffer saves SRAM at the cost of more, shorter writes. Set it from the build flags.
+#ifndef VIRTUAL_SHIELD_WRITE_BUFFER
+#define VIRTUAL_SHIELD_WRITE_BUFFER 64
+#endif
+
+// Sensor table slots: the sensor types (letters) share them round robin, so an event only walks the sensors of
+// the types in its slot. Up to 26 (one slot per type); more slots cost a pointer each. Set it from the build flags.
+#ifndef VIRTUAL_SHIELD_SENSOR_SLOTS
+#define VIRTUAL_SHIELD_SENSOR_SLOTS 4
+#endif
+
+const int messageGapTimeout = 500;
+const char firstSensorType = 'A';
+const int sensorTypeCount = 26;
+const int sensorSlotCount = VIRTUAL_SHIELD_SENSOR_SLOTS;
+static_assert(sensorSlotCount > 0 && sensorSlotCount <= sensorTypeCount, "one to 26 sensor slots");
 
 const int maxReadBuffer = 128;
 const int maxJsonReadBuffer = 130;
-
-char readBuffer[maxReadBuffer];
+const int maxWriteBuffer = VIRTUAL_SHIELD_WRITE_BUFFER;
+const long finishedRequestLifetime = 30000;
+const int maxSuppressedIds = 4;
+const int defaultPrecision = 4;
+const int maxPrecision = 6;
+const long powersOfTen[maxPrecision + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+// Messages are parsed in place, and the strings of an event point into its read buffer. A buffer is kept out of
+// turn (pinned) while its event is dispatched, so a handler may wait for more events: they are read into the
+// other buffer. While every buffer is pinned (a handler of an event received during a wait waits in turn),
+// reading pauses (readBuffer is 0) until one is handed back.
+const int readBufferCount = 2;
+char readBuffers[readBufferCount][maxReadBuffer];
+char* readBuffer = readBuffers[0];
 int readBufferIndex = 0;
+unsigned int pinnedReadBuffers = 0;
 
-int bracketCount = 0;
+static_assert(maxWriteBuffer > 0, "messages are written through the write buffer");
+char writeBuffer[maxWriteBuffer];
+FrameWriter frame(writeBuffer, maxWriteBuffer);
+
+// States of the inbound json tokenizer, fed one byte at a time.
+enum ReadState
+{
+	WaitingForObject = 0,
+	WaitingForKey = 1,
+	ReadingKey = 2,
+	WaitingForValue = 3,
+	ReadingText = 4,
+	ReadingRaw = 5,
+	ReadingNested = 6
+};
+
+// Each pair is read into the buffer as: kind, key, 0, value, 0 (quotes and escapes removed).
+const char TEXT_TOKEN = 'T';
+const char RAW_TOKEN = 'R';
+
+ReadState readState = WaitingForObject;
+char quoteChar = 0;
+bool isEscaped = false;
+bool isReadOverflow = false;
+int nestedDepth = 0;
+int pairStart = 0;
+
+// CRC-8 of the message read so far, and of the message up to the last pair (a trailing 'Crc' pair).
+uint8_t readCrc = 0;
+uint8_t pairCrc = 0;
+
+// Once the remote device sends checksums (negotiated in START), messages without one are rejected.
+bool isChecksumActive = false;
+unsigned long lastReadMillis = 0;
+
+// Kinds of messages read completely.
+const char TOKENS_MESSAGE = 'J';
+const char BINARY_MESSAGE = 'B';
+// A queue entry standing for the message reassembled in the chunk buffer (no bytes follow its header).
+const char CHUNKED_MESSAGE = 'C';
+
+// A message read completely but not yet dispatched (when it did not fit in the receive queue).
+char readyKind = 0;
+int readyLength = 0;
+bool isReadySystem = false;
+
+// Writes of system replies (PONG, START) are sent ahead of queued messages.
+bool isUrgentWrite = false;
+
+// System replies that came due while a batch was open; they are sent once it is committed.
+enum HeldReply
+{
+	HeldPong = 1,
+	HeldStart = 2,
+	HeldCodec = 4
+};
+
+uint8_t heldReplies = 0;
+WireCodec heldCodec = JsonWireCodec;
+
+// Batches are only sent once the remote device answered START with BATCH.
+bool isBatchAccepted = false;
+
+// Optional ring of read messages waiting for getEvent(): kind, length (2 bytes), then the message.
+char* receiveQueue = 0;
+int receiveQueueSize = 0;
+int receiveQueueHead = 0;
+int receiveQueueUsed = 0;
+
+// Reassembly of large messages sent by the remote device in fragments (chunks).
+char* chunkBuffer = 0;
+int chunkBufferSize = 0;
+int chunkLength = 0;
+int chunkId = 0;
+int chunkNext = 0;
+// The reassembled message waits in the receive queue for the messages received before it.
+bool isChunkQueued = false;
+int binaryFrameRemaining = 0;
+bool isBinaryFrameLength = false;
 long lastOpenRequest = 0;
+
+// The keepalive interval, doubled after each keepalive the remote device did not answer.
+long keepaliveInterval = requestInterval;
 bool isArrayStarted = false;
+int batchId = 0;
+int batchCount = 0;
+int lastWriteId = 0;
+int drainingId = 0;
 int recentEventErrorId = 0;
 
-Sensor* sensors[maxRememberedSensors];
-int sensorCount = 0;
+// The messages last written for each cache key (see VirtualShield::setOutputCache).
+OutputCacheEntry* outputCache = 0;
+int outputCacheSize = 0;
+int outputCacheHitId = 0;
+
+// Requests awaiting their response (see VirtualShield::setRequestTable).
+PendingRequest* pendingRequests = 0;
+int pendingRequestCount = 0;
+
+// Retransmitted requests already answered; the acks still expected to the copies (same id, ResultId and
+// Result as the answer) are dropped. Other events with the id, like button presses, still arrive.
+struct SuppressedId
+{
+	int id;
+	long resultId;
+	unsigned int resultHash;
+	uint8_t count;
+	unsigned long until;
+};
+
+SuppressedId* suppressedIds = 0;
+int suppressedIdCount = 0;
+
+/// <summary>
+/// Keeps copies of recently sent messages by id, so a message lost on the way can be sent again.
+/// Each entry is: id, length, message. The oldest entries make room for new ones.
+/// </summary>
+class SentMessages : public Print
+{
+public:
+	char* buffer = 0;
+	int size = 0;
+
+	/// <summary>
+	/// Keeps the messages in the buffer from now on; those kept before are forgotten.
+	/// </summary>
+	void setBuffer(char* buffer, int size)
+	{
+		this->buffer = buffer;
+		this->size = size;
+		used = 0;
+		recording = -1;
+	}
+
+	/// <summary>
+	/// Starts recording the message with the id.
+	/// </summary>
+	void begin(int id)
+	{
+		if (recording >= 0)
+		{
+			// the last message was never ended
+			used = recording;
+			recording = -1;
+		}
+
+		if (!buffer)
+		{
+			return;
+		}
+
+		remove(id);
+		if (makeRoom(2 * sizeof(int)))
+		{
+			recording = used;
+			memcpy(buffer + used, &id, sizeof(int));
+			used += 2 * sizeof(int);
+		}
+	}
+
+	/// <summary>
+	/// Ends recording; the message is kept.
+	/// </summary>
+	void end()
+	{
+		if (recording >= 0)
+		{
+			int length = used - recording - 2 * sizeof(int);
+			memcpy(buffer + recording + sizeof(int), &length, sizeof(int));
+			recording = -1;
+		}
+	}
+
+	/// <summary>
+	/// Finds the message with the id.
+	/// </summary>
+	/// <returns>The message, or 0 if not kept.</returns>
+	const char* find(int id, int& length)
+	{
+		int offset = offsetOf(id);
+		if (offset < 0)
+		{
+			return 0;
+		}
+
+		memcpy(&length, buffer + offset + sizeof(int), sizeof(int));
+		return buffer + offset + 2 * sizeof(int);
+	}
+
+	/// <summary>
+	/// Forgets the message with the id.
+	/// </summary>
+	void remove(int id)
+	{
+		int offset = offsetOf(id);
+		if (offset >= 0)
+		{
+			removeAt(offset);
+		}
+	}
+
+	size_t write(uint8_t c) override
+	{
+		return write(&c, 1);
+	}
+
+	size_t write(const uint8_t* data, size_t count) override
+	{
+		if (recording < 0)
+		{
+			return count;
+		}
+
+		if (!makeRoom(count))
+		{
+			// too long to keep
+			used = recording;
+			recording = -1;
+			return count;
+		}
+
+		memcpy(buffer + used, data, count);
+		used += count;
+		return count;
+	}
+
+	using Print::write;
+
+private:
+	int used = 0;
+	int recording = -1;
+
+	int entrySize(int offset)
+	{
+		int length;
+		memcpy(&length, buffer + offset + sizeof(int), sizeof(int));
+		return 2 * sizeof(int) + length;
+	}
+
+	int offsetOf(int id)
+	{
+		for (int offset = 0; offset < used && offset != recording; offset += entrySize(offset))
+		{
+			int entryId;
+			memcpy(&entryId, buffer + offset, sizeof(int));
+			if (entryId == id)
+			{
+				return offset;
+			}
+		}
+
+		return -1;
+	}
+
+	void removeAt(int offset)
+	{
+		int length = entrySize(offset);
+		memmove(buffer + offset, buffer + offset + length, used - offset - length);
+		used -= length;
+		if (recording > offset)
+		{
+			recording -= length;
+		}
+	}
+
+	bool makeRoom(int count)
+	{
+		while (used + count > size)
+		{
+			if (used == 0 || recording == 0)
+			{
+				return false;
+			}
+
+			removeAt(0);
+		}
+
+		return true;
+	}
+};
+
+SentMessages sentMessages;
+
+// The first sensor of each slot; the sensors of the types sharing the slot are chained through nextSensor.
+Sensor* sensorsBySlot[sensorSlotCount];
+
+/// <summary>
+/// Finds the first sensor of a type in a chain of sensors.
+/// </summary>
+/// <param name="sensor">The first sensor of the chain to look at.</param>
+/// <param name="sensorType">The type of sensor.</param>
+/// <returns>The sensor, or 0 if none.</returns>
+Sensor* firstOfType(Sensor* sensor, char sensorType)
+{
+	while (sensor && sensor->sensorType != sensorType)
+	{
+		sensor = sensor->nextSensor;
+	}
+
+	return sensor;
+}
 
 /// <summary>
 /// Initializes a new instance of the <see cref="VirtualShield"/> class.
@@ -97,20 +449,38 @@ VirtualShield::VirtualShield()
 }
 
 /// <summary>
-/// Adds a sensor to the list of known sensors in order to match and dispatch for incoming events.
+/// Adds a sensor to the known sensors in order to match and dispatch for incoming events.
+/// Every sensor of a type receives the events of that type, in the order added.
 /// </summary>
 /// <param name="sensor">The sensor to add.</param>
-/// <returns>true if it was added, false if the maxRememberedSensors is reached.</returns>
+/// <returns>true if it was added, false (and counted in rejectedSensors) if its type is not a letter.</returns>
 bool VirtualShield::addSensor(Sensor* sensor) {
-	if (sensorCount == maxRememberedSensors)
+	Sensor** link = findSensors(sensor->sensorType);
+	if (!link)
 	{
+		rejectedSensors++;
 		return false;
 	}
 
-	sensors[sensorCount++] = sensor;
+	while (*link)
+	{
+		link = &(*link)->nextSensor;
+	}
+
+	*link = sensor;
 	return true;
 }
 
+/// <summary>
+/// Finds the sensors of the slot of a type; they may include sensors of other types (see firstOfType()).
+/// </summary>
+/// <param name="sensorType">The type of sensor.</param>
+/// <returns>The address of the first sensor of the slot (0 if none), or 0 if not a sensor type.</returns>
+Sensor** VirtualShield::findSensors(char sensorType) {
+	int index = sensorType - firstSensorType;
+	return index >= 0 && index < sensorTypeCount ? &sensorsBySlot[index % sensorSlotCount] : 0;
+}
+
 /// <summary>
 /// Sets the port for bluetooth (this only works for __AVR_ATmega32U4__ where there are more than one port).
 /// </summary>
@@ -119,20 +489,44 @@ void VirtualShield::setPort(int port)
 {
 	if (port == 0) {
 		_VShieldSerial = &VIRTUAL_SERIAL_PORT0;
+		this->port = port;
 	}
 	else if (port == 1) {
 		_VShieldSerial = &VIRTUAL_SERIAL_PORT1;
+		this->port = port;
 	}
 }
 
 /// <summary>
-/// Begins the specified bit rate.
+/// Begins the specified bit rate on the serial port chosen with setPort.
+/// The ports are opened by their own types (on a Leonardo, Serial is the USB port and not a HardwareSerial).
 /// </summary>
 /// <param name="bitRate">The bit rate to use for the virtual shield serial connection.</param>
 void VirtualShield::begin(long bitRate)
 {
-    reinterpret_cast<HardwareSerial *>(_VShieldSerial)->begin(bitRate);
-	delay(500);
+	if (port == 0) {
+		VIRTUAL_SERIAL_PORT0.begin(bitRate);
+		delay(500);
+		begin(VIRTUAL_SERIAL_PORT0);
+	}
+	else {
+		VIRTUAL_SERIAL_PORT1.begin(bitRate);
+		delay(500);
+		begin(VIRTUAL_SERIAL_PORT1);
+	}
+}
+
+/// <summary>
+/// Begins communication over an already opened stream (i.e. SoftwareSerial, or a recording stream when running off-target).
+/// </summary>
+/// <param name="stream">The stream to use for the virtual shield connection.</param>
+void VirtualShield::begin(Stream& stream)
+{
+	_VShieldSerial = &stream;
+	frame.attach(_VShieldSerial);
+#ifdef debugSerial
+	frame.mirror = &Serial;
+#endif
     flush();
     sendStart();
 
@@ -152,221 +546,1456 @@ void VirtualShield::begin(long bitRate)
 /// </summary>
 int VirtualShield::block(int id, bool blocking, long timeout, int watchForResultId)
 {
-    return allowAutoBlocking && blocking ? waitFor(id, timeout, watchForResultId) : id;
+	// a batched message is not sent until commitBatch, and a cached one was answered when first sent
+    return allowAutoBlocking && blocking && !batchId && id != outputCacheHitId ? waitFor(id, timeout, watchForResultId) : id;
 }
 
 /// <summary>
-/// Flushes this instance onto the serial port.
+/// Begins a batch. Messages written until commitBatch() are gathered into a single BATCH message,
+/// sent with one flush and acknowledged once by the remote device under the batch id.
+/// When the remote device did not announce BATCH support, no batch is begun and messages are sent one by one.
 /// </summary>
-void VirtualShield::flush()
+/// <returns>The id of the batch message, 0 if batches are not supported, or a negative error.</returns>
+int VirtualShield::beginBatch()
 {
-	_VShieldSerial->flush();
-	lastOpenRequest = millis();
+	if (batchId || !isBatchAccepted)
+	{
+		return batchId;
+	}
+
+	int id = beginWrite(SERVICE_NAME_BATCH);
+	if (id < 0) return id;
+
+	if (codec != JsonWireCodec)
+	{
+		writeCborKey(BATCH_KEY);
+		Cbor::writeIndefinite(frame, CBOR_ARRAY);
+	}
+	else if (sendFlashFragment(BATCH_START) != 0) return SERIAL_ERROR;
+
+	batchId = id;
+	batchCount = 0;
+	return id;
 }
 
 /// <summary>
-/// Gets zero or one available events for processing.
+/// Commits (sends) the batch begun with beginBatch().
 /// </summary>
-/// <param name="shieldEvent">The address of ShieldEvent to populate.</param>
-/// <returns>true if an event was populated</returns>
-bool VirtualShield::getEvent(ShieldEvent* shieldEvent) {
-	bool hasEvent = false;
-
-	if (_VShieldSerial->available() == 0 && millis() > lastOpenRequest + requestInterval) //and timing!
+/// <param name="blocking">true to wait for the remote device to acknowledge the batch.</param>
+/// <returns>The id of the batch message, or a negative error.</returns>
+int VirtualShield::commitBatch(bool blocking)
+{
+	if (!batchId)
 	{
-#ifdef debugSerial
-		Serial.print(AWAITING_MESSAGE);
-#endif
-		_VShieldSerial->write(AWAITING_MESSAGE);
-		lastOpenRequest = millis();
+		return SERIAL_SUCCESS;
 	}
 
-	bool hadData = false;
-	while (_VShieldSerial->available() > 0) {
-		hadData = true;
-		char c = _VShieldSerial->read();
+	int id = batchId;
+	batchId = 0;
+	lastWriteId = id;
 
-#ifdef debugSerialIn
-		Serial.print(c);
-#endif
+	if (codec != JsonWireCodec)
+	{
+		Cbor::writeBreak(frame);
+		Cbor::writeBreak(frame);
+	}
+	else if (sendFlashFragment(BATCH_END) != 0) return SERIAL_ERROR;
 
-		if (readBufferIndex < maxReadBuffer-1) {
-			readBuffer[readBufferIndex++] = c;
-		}
-		
-		if (c == '{') {
-			bracketCount++;
-		}
-		else if (c == '}') {
-			if (--bracketCount < 1) {
-				bracketCount = 0;
+	frame.capture = 0;
+	sentMessages.end();
 
-				if (readBufferIndex < maxReadBuffer) {
-					readBuffer[readBufferIndex++] = 0;
-					onStringReceived(readBuffer, readBufferIndex, shieldEvent);
-					hasEvent = true;
-					readBufferIndex = 0;
-					break;
-				}
+	bool sent = frame.end();
+	this->flush();
 
-				readBufferIndex = 0;
-			}
-		}
+	uint8_t held = heldReplies;
+	heldReplies = 0;
+	if (held & HeldStart)
+	{
+		sendStart();
+	}
+
+	if (held & HeldCodec)
+	{
+		useCodec(heldCodec);
 	}
 
-	if (hadData)
+	if (held & HeldPong)
 	{
-		lastOpenRequest = millis() - requestInterval + perMessageInterval;
+		sendPingBack(0);
 	}
 
-	return hasEvent;
+	if (!sent) return SERIAL_ERROR;
+
+	return block(id, blocking);
 }
 
 /// <summary>
-/// Sends the ping back form a ping request.
+/// Flushes this instance onto the serial port. When sending async, the message is left to drain from getEvent().
 /// </summary>
-/// <param name="shieldEvent">The shield event.</param>
-void VirtualShield::sendStart()
+void VirtualShield::flush()
 {
-    EPtr eptrs[] = { EPtr(ACTION, START), EPtr(MemPtr, TYPE, "!"), EPtr(LEN, maxReadBuffer) };
-    writeAll(SERVICE_NAME_SERVICE, eptrs, 3);
+	if (frame.async)
+	{
+		drainingId = lastWriteId;
+	}
+	else
+	{
+		_VShieldSerial->flush();
+	}
+
+	// a message also serves as the keepalive; its response is polled for sooner
+	lastOpenRequest = millis();
+	keepaliveInterval = isUrgentWrite ? minKeepaliveInterval : pendingKeepaliveInterval;
 }
 
 /// <summary>
-/// Sends the ping back form a ping request.
+/// Sets the intervals of keepalive requests ("{}") on an idle line. The interval doubles up to the maximum
+/// while nothing is read, from the minimum after a message was read, or from the pending interval after
+/// one was sent (a response is expected). Setting all three the same polls at a fixed rate.
 /// </summary>
-/// <param name="shieldEvent">The shield event.</param>
-void VirtualShield::sendPingBack(ShieldEvent* shieldEvent)
+/// <param name="minInterval">The interval in milliseconds after activity.</param>
+/// <param name="maxInterval">The longest interval in milliseconds.</param>
+/// <param name="pendingInterval">The interval in milliseconds while a response is expected.</param>
+void VirtualShield::setKeepalive(long minInterval, long maxInterval, long pendingInterval)
 {
-	EPtr eptrs[] = { EPtr(ACTION, PONG), EPtr(MemPtr, TYPE, "!") };
-	writeAll(SERVICE_NAME_SERVICE, eptrs, 2);
+	minKeepaliveInterval = minInterval;
+	maxKeepaliveInterval = maxInterval < minInterval ? minInterval : maxInterval;
+	pendingKeepaliveInterval = pendingInterval;
+	keepaliveInterval = minInterval;
 }
 
 /// <summary>
-/// Event called when a valid json message was received. 
-/// Dispatches to added sensors that match the incoming Type.
+/// Enables or disables async sending. endWrite() then queues the message and returns without waiting for the
+/// transmit buffer to empty; getEvent() sends the rest as the stream reports room (availableForWrite).
+/// Streams that never report room, like SoftwareSerial, are still written blocking.
 /// </summary>
-/// <param name="root">The root json object.</param>
-/// <param name="shieldEvent">The shield event.</param>
-void VirtualShield::onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) {
-	const char* sensorType = static_cast<const char *>(root["Type"]);
-
-	shieldEvent->tag = static_cast<const char*>(root["Tag"]);
-
-	shieldEvent->id = static_cast<int>(root["Pid"]);
-	if (shieldEvent->id == 0) {
-		shieldEvent->id = static_cast<int>(root["Id"]);
-	}
-
-	shieldEvent->resultId = static_cast<long>(root["ResultId"]);
-	shieldEvent->tag = sensorType;
-
-	shieldEvent->result = static_cast<const char *>(root["Result"]);
-	shieldEvent->resultHash = hash(shieldEvent->result);
-	shieldEvent->action = static_cast<const char *>(root["Action"]);
-	shieldEvent->actionHash = hash(shieldEvent->action);
-	shieldEvent->value = static_cast<double>(root["Value"]);
+/// <param name="enable">true to send async.</param>
+void VirtualShield::enableAsyncSend(bool enable)
+{
+	// anything still queued is sent ahead of the next frame
+	frame.async = enable;
+}
 
-	if (sensorType) {
-		// special '!' Type which means remote device just connected/reconnected
-		if (sensorType[0] == SYSTEM_EVENT)
-		{
-			shieldEvent->cargo = &root;
-			bool refresh = false;
-			switch (shieldEvent->resultHash)
-			{
-			case PING_HASH:
-				sendPingBack(shieldEvent);
-				break;
-			case REFRESH_HASH:
-				refresh = true;
-				break;
-			case CONNECT_HASH:
-				refresh = true;
-				if (onConnect)
-				{
-					onConnect(shieldEvent);
-				}
-				break;
-			case SUSPEND_HASH:
-				if (onSuspend)
-				{
-					onSuspend(shieldEvent);
-				}
-				break;
-			case RESUME_HASH:
-				refresh = true;
-				if (onResume)
-				{
-					onResume(shieldEvent);
-				}
-				break;
-			}
+/// <summary>
+/// Sends what the stream can take of queued (async) messages, and reports when they have drained.
+/// </summary>
+void VirtualShield::pumpWrites()
+{
+	if (!frame.isOpen() && frame.pump() && drainingId)
+	{
+		int id = drainingId;
+		drainingId = 0;
 
-			if (refresh && onRefresh)
-			{
-				onRefresh(shieldEvent);
-			}					  
-		} 
-		else
+		if (this->onDrained)
 		{
-			const char sensorTypeChar = sensorType[0];
-			for (int i = 0; i < sensorCount; i++)
-			{
-				// check each sensor for matching Type
-				if (sensors[i]->sensorType == sensorTypeChar) {
-					sensors[i]->onJsonReceived(root, shieldEvent);
-
-					if (shieldEvent->shieldEventType == SensorShieldEventType) {
-						SensorEvent* sensorEvent = static_cast<SensorEvent*>(shieldEvent);
-						sensorEvent->sensor = sensors[i];
-					}
-
-					break;
-				}
-			}
+			this->onDrained(id);
 		}
 	}
-
-	if (onEvent)
-	{
-		onEvent(shieldEvent);
-	}
 }
 
 /// <summary>
-/// Event callback for when a full json string is received.
+/// Finds a read buffer that is neither read into nor holding an event being dispatched.
 /// </summary>
-/// <param name="json">The json string.</param>
-/// <param name="shieldEvent">The shield event to populate.</param>
-void VirtualShield::onJsonStringReceived(char* json, ShieldEvent* shieldEvent) {
-    StaticJsonBuffer<maxJsonReadBuffer> jsonBuffer;
-	JsonObject& root = jsonBuffer.parseObject(json);
-	if (root.success()) {
-		onJsonReceived(root, shieldEvent);
-	} 
-	else
+/// <returns>The buffer, or 0 if none.</returns>
+char* freeReadBuffer()
+{
+	for (int i = 0; i < readBufferCount; i++)
 	{
-		//Serial.print("FAILED");
+		if (readBuffers[i] != readBuffer && !(pinnedReadBuffers & (1u << i)))
+		{
+			return readBuffers[i];
+		}
 	}
+
+	return 0;
 }
 
 /// <summary>
-/// Event callback for when a full string is received.
+/// Hands over the read buffer holding a complete message and continues reading into a free one, if any.
 /// </summary>
-/// <param name="buffer">The buffer.</param>
-/// <param name="length">The length.</param>
-/// <param name="shieldEvent">The shield event.</param>
-void VirtualShield::onStringReceived(char* buffer, int length, ShieldEvent* shieldEvent) {
-	char *json = new char[length];
-	strcpy(json, buffer);
-	//Serial.print(json);
-	onJsonStringReceived(json, shieldEvent);
-	free(json);
+/// <returns>The buffer holding the complete message.</returns>
+char* swapReadBuffer()
+{
+	char* message = readBuffer;
+	readBuffer = freeReadBuffer();
+	readBufferIndex = 0;
+	return message;
 }
 
 /// <summary>
-/// Receives events as long as they exist, or until an optional timeout occurs.
+/// Stores a byte of the message being read, remembering if the buffer overflowed.
+/// </summary>
+/// <param name="c">The byte.</param>
+void storeReadByte(char c)
+{
+	if (readBufferIndex < maxReadBuffer)
+	{
+		readBuffer[readBufferIndex++] = c;
+	}
+	else
+	{
+		isReadOverflow = true;
+	}
+}
+
+/// <summary>
+/// Reads a byte of a quoted key or text, removing escapes.
+/// </summary>
+/// <param name="c">The byte.</param>
+/// <returns>true at the closing quote.</returns>
+bool readQuoted(char c)
+{
+	if (isEscaped)
+	{
+		isEscaped = false;
+	}
+	else if (c == '\\')
+	{
+		isEscaped = true;
+		return false;
+	}
+	else if (c == quoteChar)
+	{
+		storeReadByte(0);
+		return true;
+	}
+
+	storeReadByte(c);
+	return false;
+}
+
+/// <summary>
+/// Adds a byte to a CRC-8 (polynomial 0x07).
+/// </summary>
+/// <param name="crc">The CRC so far.</param>
+/// <param name="c">The byte.</param>
+/// <returns>The CRC including the byte.</returns>
+uint8_t crc8(uint8_t crc, uint8_t c)
+{
+	crc ^= c;
+	for (int i = 0; i < 8; i++)
+	{
+		crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+	}
+
+	return crc;
+}
+
+/// <summary>
+/// Feeds one byte to the json tokenizer. Keys and values are stored as they arrive, so a message is
+/// ready to dispatch on its last byte. Nested objects and arrays are kept as raw json.
+/// </summary>
+/// <param name="c">The byte.</param>
+/// <returns>true when a complete message was read.</returns>
+bool readJsonByte(char c)
+{
+	uint8_t crc = readState == WaitingForObject ? 0 : readCrc;
+	readCrc = crc8(crc, c);
+
+	switch (readState)
+	{
+	case WaitingForObject:
+		if (c == '{')
+		{
+			readBufferIndex = 0;
+			isReadOverflow = false;
+			readState = WaitingForKey;
+		}
+		break;
+	case WaitingForKey:
+		if (c == '}')
+		{
+			readState = WaitingForObject;
+			return !isReadOverflow;
+		}
+
+		if (c == '\'' || c == '"')
+		{
+			quoteChar = c;
+			pairStart = readBufferIndex;
+			pairCrc = crc;
+			storeReadByte(RAW_TOKEN);
+			readState = ReadingKey;
+		}
+		break;
+	case ReadingKey:
+		if (readQuoted(c))
+		{
+			readState = WaitingForValue;
+		}
+		break;
+	case WaitingForValue:
+		if (c == '\'' || c == '"')
+		{
+			if (!isReadOverflow)
+			{
+				readBuffer[pairStart] = TEXT_TOKEN;
+			}
+
+			quoteChar = c;
+			readState = ReadingText;
+		}
+		else if (c == '{' || c == '[')
+		{
+			nestedDepth = 1;
+			quoteChar = 0;
+			storeReadByte(c);
+			readState = ReadingNested;
+		}
+		else if (c != ':' && c != ' ' && c != '\t' && c != '\r' && c != '\n')
+		{
+			storeReadByte(c);
+			readState = ReadingRaw;
+		}
+		break;
+	case ReadingText:
+		if (readQuoted(c))
+		{
+			readState = WaitingForKey;
+		}
+		break;
+	case ReadingRaw:
+		if (c == ',' || c == '}')
+		{
+			storeReadByte(0);
+			readState = WaitingForKey;
+
+			if (c == '}')
+			{
+				readState = WaitingForObject;
+				return !isReadOverflow;
+			}
+		}
+		else if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+		{
+			storeReadByte(c);
+		}
+		break;
+	case ReadingNested:
+		storeReadByte(c);
+		if (quoteChar)
+		{
+			if (isEscaped)
+			{
+				isEscaped = false;
+			}
+			else if (c == '\\')
+			{
+				isEscaped = true;
+			}
+			else if (c == quoteChar)
+			{
+				quoteChar = 0;
+			}
+		}
+		else if (c == '\'' || c == '"')
+		{
+			quoteChar = c;
+		}
+		else if (c == '{' || c == '[')
+		{
+			nestedDepth++;
+		}
+		else if ((c == '}' || c == ']') && --nestedDepth == 0)
+		{
+			storeReadByte(0);
+			readState = WaitingForKey;
+		}
+		break;
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Verifies and removes the checksum of a read message: a trailing 'Crc' pair holding the CRC-8 of the json text
+/// before its key, or the last byte of a binary frame holding the CRC-8 of the rest.
+/// </summary>
+/// <param name="kind">The kind of message.</param>
+/// <param name="isAllowed">true if checksums were offered to the remote device.</param>
+/// <param name="isSystem">true if a system message, accepted without a checksum (a new connection renegotiates).</param>
+/// <returns>true if the message is intact.</returns>
+bool verifyChecksum(char kind, bool isAllowed, bool isSystem)
+{
+	bool isRequired = isAllowed && isChecksumActive && !isSystem;
+
+	if (kind == BINARY_MESSAGE)
+	{
+		if (!isRequired)
+		{
+			return true;
+		}
+
+		if (readBufferIndex == 0)
+		{
+			return false;
+		}
+
+		uint8_t crc = 0;
+		for (int i = 0; i < readBufferIndex - 1; i++)
+		{
+			crc = crc8(crc, readBuffer[i]);
+		}
+
+		return (uint8_t)readBuffer[--readBufferIndex] == crc;
+	}
+
+	const char* key = readBuffer + pairStart + 1;
+	if (readBufferIndex == 0 || strcmp_P(key, CHECKSUM_KEY) != 0)
+	{
+		return !isRequired;
+	}
+
+	const char* value = key + strlen(key) + 1;
+	readBufferIndex = pairStart;
+	if (atoi(value) != pairCrc)
+	{
+		return false;
+	}
+
+	// the remote device sends checksums from now on
+	isChecksumActive = isAllowed;
+	return true;
+}
+
+/// <summary>
+/// Determines whether read tokens are a system ('!' type) message, dispatched ahead of queued messages.
+/// </summary>
+/// <param name="tokens">The tokens (kind, key, 0, value, 0 per pair).</param>
+/// <param name="length">The length of the tokens.</param>
+/// <returns>true if a system message.</returns>
+bool isSystemMessage(const char* tokens, int length)
+{
+	const char* end = tokens + length;
+	while (tokens < end)
+	{
+		const char* key = tokens + 1;
+		const char* value = key + strlen(key) + 1;
+		if (strcmp(key, "Type") == 0)
+		{
+			return value[0] == SYSTEM_EVENT;
+		}
+
+		tokens = value + strlen(value) + 1;
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Copies bytes into or out of the receive queue ring.
+/// </summary>
+/// <param name="data">The bytes to queue, or the destination of dequeued bytes.</param>
+/// <param name="length">The count of bytes.</param>
+/// <param name="isPush">true to queue, false to dequeue.</param>
+void moveQueueBytes(char* data, int length, bool isPush)
+{
+	int position = isPush ? (receiveQueueHead + receiveQueueUsed) % receiveQueueSize : receiveQueueHead;
+	for (int i = 0; i < length; i++)
+	{
+		if (isPush)
+		{
+			receiveQueue[position] = data[i];
+		}
+		else
+		{
+			data[i] = receiveQueue[position];
+		}
+
+		if (++position == receiveQueueSize)
+		{
+			position = 0;
+		}
+	}
+
+	if (isPush)
+	{
+		receiveQueueUsed += length;
+	}
+	else
+	{
+		receiveQueueHead = position;
+		receiveQueueUsed -= length;
+	}
+}
+
+/// <summary>
+/// Sets the buffer used to queue messages read by poll() until getEvent() dispatches them.
+/// A larger queue absorbs bursts while callbacks or waits keep the sketch busy.
+/// </summary>
+/// <param name="buffer">The buffer.</param>
+/// <param name="size">The size of the buffer.</param>
+void VirtualShield::setReceiveQueue(char* buffer, int size)
+{
+	receiveQueue = buffer;
+	receiveQueueSize = size;
+	receiveQueueHead = 0;
+	receiveQueueUsed = 0;
+	isChunkQueued = false;
+}
+
+/// <summary>
+/// Reads (and decodes) what is available on the stream. Complete messages are queued for getEvent(), or held
+/// when the queue is full (reading then pauses, as it does while every read buffer holds an event being dispatched).
+/// Call from long running code to keep the serial buffer from overflowing.
+/// </summary>
+/// <returns>The count of bytes read.</returns>
+int VirtualShield::poll() {
+	int count = 0;
+	char kind = 0;
+
+	while (!readyKind && readBuffer && _VShieldSerial->available() > 0) {
+		count++;
+		char c = _VShieldSerial->read();
+
+#ifdef debugSerialIn
+		Serial.print(c);
+#endif
+
+		unsigned long now = millis();
+		if ((readState != WaitingForObject || isBinaryFrameLength || binaryFrameRemaining > 0) && now - lastReadMillis > messageGapTimeout) {
+			// the rest of the message was lost; start over
+			framingErrors++;
+			readState = WaitingForObject;
+			isBinaryFrameLength = false;
+			binaryFrameRemaining = 0;
+		}
+
+		lastReadMillis = now;
+
+		if (isBinaryFrameLength) {
+			// the length byte of a binary frame
+			isBinaryFrameLength = false;
+			binaryFrameRemaining = (uint8_t)c;
+			readBufferIndex = 0;
+			isReadOverflow = false;
+			continue;
+		}
+
+		if (binaryFrameRemaining > 0) {
+			storeReadByte(c);
+
+			if (--binaryFrameRemaining == 0) {
+				kind = BINARY_MESSAGE;
+			}
+		}
+		else if (readState == WaitingForObject && (uint8_t)c == BINARY_FRAME_START) {
+			isBinaryFrameLength = true;
+		}
+		else {
+			if (c == '{' && (readState == WaitingForKey || readState == ReadingKey || readState == ReadingRaw)) {
+				// a new message began before the last one ended (a byte was lost); read the new one
+				framingErrors++;
+				readState = WaitingForObject;
+			}
+
+			if (readJsonByte(c)) {
+				kind = TOKENS_MESSAGE;
+			}
+		}
+
+		if (!kind) {
+			continue;
+		}
+
+		bool isSystem = kind == TOKENS_MESSAGE && isSystemMessage(readBuffer, readBufferIndex);
+
+		if (!isReadOverflow && !verifyChecksum(kind, allowChecksum, isSystem)) {
+			checksumErrors++;
+			readBufferIndex = 0;
+			kind = 0;
+			continue;
+		}
+
+		if (isReadOverflow) {
+			// too long for the read buffer
+			readBufferIndex = 0;
+		}
+		else if (!isSystem && receiveQueue && receiveQueueUsed + readBufferIndex + 3 <= receiveQueueSize) {
+			char header[3] = { kind, static_cast<char>(readBufferIndex & 0xFF), static_cast<char>(readBufferIndex >> 8) };
+			moveQueueBytes(header, 3, true);
+			moveQueueBytes(readBuffer, readBufferIndex, true);
+			readBufferIndex = 0;
+
+			if (receiveQueueUsed > receiveQueuePeak) {
+				receiveQueuePeak = receiveQueueUsed;
+			}
+		}
+		else {
+			// system messages skip the queue
+			if (receiveQueue && !isSystem) {
+				receiveQueueOverflows++;
+			}
+
+			isReadySystem = isSystem;
+			readyKind = kind;
+			readyLength = readBufferIndex;
+		}
+
+		kind = 0;
+	}
+
+	if (count > 0)
+	{
+		// more may follow shortly
+		keepaliveInterval = minKeepaliveInterval;
+		lastOpenRequest = millis() - minKeepaliveInterval + perMessageInterval;
+	}
+
+	return count;
+}
+
+/// <summary>
+/// Sets the table of requests that track() follows until their response arrives; without one, nothing is
+/// tracked (and lost messages are not sent again, see setRetransmitBuffer).
+/// </summary>
+/// <param name="requests">The entries.</param>
+/// <param name="count">The count of entries: the most requests in flight at once.</param>
+void VirtualShield::setRequestTable(PendingRequest* requests, int count)
+{
+	pendingRequests = requests;
+	pendingRequestCount = requests ? count : 0;
+	if (requests)
+	{
+		memset(requests, 0, count * sizeof(PendingRequest));
+	}
+}
+
+/// <summary>
+/// Tracks a request until its response arrives (or the timeout). Many requests may be in flight at once:
+/// send them without blocking (see enableAutoBlocking), then either get a callback as each completes,
+/// or check requestState().
+/// </summary>
+/// <param name="id">The id of the request, as returned by the write.</param>
+/// <param name="onComplete">The optional completion callback.</param>
+/// <param name="timeout">The timeout in milliseconds.</param>
+/// <param name="resultId">The ResultId to wait for, or -1 for the first response.</param>
+/// <returns>The id, or a negative error if not trackable (counted in droppedRequests when the table is full).</returns>
+int VirtualShield::track(int id, RequestCallback onComplete, long timeout, int resultId)
+{
+	if (id <= 0 || pendingRequestCount == 0)
+	{
+		return id < 0 ? id : SERIAL_ERROR;
+	}
+
+	// a request tracked again keeps its entry; otherwise take a free one, or one whose final state was never read
+	unsigned long now = millis();
+	PendingRequest* entry = 0;
+	for (int i = 0; i < pendingRequestCount; i++)
+	{
+		PendingRequest& request = pendingRequests[i];
+		if (request.id == id)
+		{
+			entry = &request;
+			break;
+		}
+
+		if (!entry && (request.id == 0 ||
+			(request.state != RequestPending && static_cast<long>(now - request.deadline) >= 0)))
+		{
+			entry = &request;
+		}
+	}
+
+	if (entry)
+	{
+		entry->id = id;
+		entry->resultId = resultId;
+		entry->deadline = now + timeout;
+		entry->onComplete = onComplete;
+		entry->state = RequestPending;
+		entry->retryAt = now + retryTimeout;
+		entry->resends = 0;
+		return id;
+	}
+
+	droppedRequests++;
+	return SERIAL_ERROR;
+}
+
+/// <summary>
+/// Gets the state of a tracked request. A request without a callback is forgotten once its final state is read,
+/// or when its entry is needed finishedRequestLifetime after it finished.
+/// </summary>
+/// <param name="id">The id of the request.</param>
+/// <returns>The state; RequestUnknown if not tracked.</returns>
+RequestState VirtualShield::requestState(int id)
+{
+	for (int i = 0; i < pendingRequestCount; i++)
+	{
+		PendingRequest& request = pendingRequests[i];
+		if (id != 0 && request.id == id)
+		{
+			RequestState state = request.state;
+			if (state != RequestPending)
+			{
+				request.id = 0;
+			}
+
+			return state;
+		}
+	}
+
+	return RequestUnknown;
+}
+
+/// <summary>
+/// Stops tracking a request, i.e. one abandoned before it completed: its callback is not called, and its
+/// entry is free for another request.
+/// </summary>
+/// <param name="id">The id of the request.</param>
+void VirtualShield::untrack(int id)
+{
+	for (int i = 0; i < pendingRequestCount; i++)
+	{
+		PendingRequest& request = pendingRequests[i];
+		if (id != 0 && request.id == id)
+		{
+			sentMessages.remove(id);
+			request.id = 0;
+		}
+	}
+}
+
+/// <summary>
+/// Sets the buffer that keeps copies of sent messages, and the policy for sending them again when the response
+/// to a tracked (or blocking) request is late: up to retries times, first after retryTimeout, doubling after
+/// each. Requests are only followed with a request table (see setRequestTable). Later answers to the copies are
+/// dropped (counted in duplicatesSuppressed); the start of the buffer keeps the requests they answer.
+/// </summary>
+/// <param name="buffer">The buffer.</param>
+/// <param name="size">The size of the buffer.</param>
+/// <param name="retries">The most times a message is sent again.</param>
+/// <param name="retryTimeout">The milliseconds to wait for a response before the first retry.</param>
+void VirtualShield::setRetransmitBuffer(char* buffer, int size, int retries, long retryTimeout)
+{
+	suppressedIds = 0;
+	suppressedIdCount = 0;
+	if (buffer)
+	{
+		int align = alignof(SuppressedId);
+		int skip = (align - reinterpret_cast<uintptr_t>(buffer) % align) % align;
+		int reserved = skip + maxSuppressedIds * sizeof(SuppressedId);
+		if (size >= 2 * reserved)
+		{
+			suppressedIds = reinterpret_cast<SuppressedId*>(buffer + skip);
+			suppressedIdCount = maxSuppressedIds;
+			memset(suppressedIds, 0, maxSuppressedIds * sizeof(SuppressedId));
+			buffer += reserved;
+			size -= reserved;
+		}
+	}
+
+	sentMessages.setBuffer(buffer, size);
+	this->maxRetries = buffer ? retries : 0;
+	this->retryTimeout = retryTimeout;
+}
+
+/// <summary>
+/// Determines whether a message answers a copy of a request already answered, i.e. repeats that answer.
+/// </summary>
+/// <param name="root">The message, not yet dispatched.</param>
+/// <returns>true if a duplicate.</returns>
+bool isDuplicate(JsonObject& root)
+{
+	for (int i = 0; i < suppressedIdCount; i++)
+	{
+		SuppressedId& suppressed = suppressedIds[i];
+		if (suppressed.count == 0)
+		{
+			continue;
+		}
+
+		if (static_cast<long>(millis() - suppressed.until) >= 0)
+		{
+			// the copies were lost as well
+			suppressed.count = 0;
+			continue;
+		}
+
+		int pid = root["Pid"];
+		int id = pid ? pid : static_cast<int>(root["Id"]);
+		if (suppressed.id == id && suppressed.resultId == static_cast<long>(root["ResultId"]) &&
+			suppressed.resultHash == VirtualShield::hash(static_cast<const char*>(root["Result"])))
+		{
+			suppressed.count--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Completes the tracked requests the event responds to.
+/// </summary>
+/// <param name="shieldEvent">The event.</param>
+void VirtualShield::completeRequests(ShieldEvent* shieldEvent)
+{
+	for (int i = 0; i < pendingRequestCount; i++)
+	{
+		PendingRequest& request = pendingRequests[i];
+		if (request.state != RequestPending || request.id != shieldEvent->id ||
+			(request.resultId != -1 && request.resultId != shieldEvent->resultId))
+		{
+			continue;
+		}
+
+		request.state = shieldEvent->resultId < 0 ? RequestFailed : RequestCompleted;
+		request.deadline = millis() + finishedRequestLifetime;
+		sentMessages.remove(request.id);
+
+		if (request.resends > 0 && suppressedIdCount > 0)
+		{
+			// the copies may be answered too; reuse the oldest slot
+			SuppressedId* slot = &suppressedIds[0];
+			for (int j = 0; j < suppressedIdCount; j++)
+			{
+				if (suppressedIds[j].count == 0 || static_cast<long>(suppressedIds[j].until - slot->until) < 0)
+				{
+					slot = &suppressedIds[j];
+				}
+			}
+
+			slot->id = request.id;
+			slot->resultId = shieldEvent->resultId;
+			slot->resultHash = shieldEvent->resultHash;
+			slot->count = request.resends;
+			slot->until = millis() + (retryTimeout << request.resends);
+		}
+
+		if (request.onComplete)
+		{
+			// free the entry first, so the callback may track a new request
+			request.id = 0;
+			request.onComplete(shieldEvent->id, shieldEvent);
+		}
+	}
+}
+
+/// <summary>
+/// Sends again the tracked requests whose response is late, and times out those past their deadline.
+/// </summary>
+void VirtualShield::expireRequests()
+{
+	unsigned long now = millis();
+	for (int i = 0; i < pendingRequestCount; i++)
+	{
+		PendingRequest& request = pendingRequests[i];
+		if (request.id == 0 || request.state != RequestPending)
+		{
+			continue;
+		}
+
+		if (static_cast<long>(now - request.deadline) < 0)
+		{
+			if (request.resends < maxRetries && static_cast<long>(now - request.retryAt) >= 0 &&
+				!frame.isOpen() && frame.pending() == 0)
+			{
+				int length;
+				const char* message = sentMessages.find(request.id, length);
+				if (message)
+				{
+					frame.begin(_VShieldSerial);
+					frame.write(reinterpret_cast<const uint8_t*>(message), length);
+					frame.end();
+					flush();
+					retransmits++;
+
+					request.resends++;
+					request.retryAt = now + (retryTimeout << request.resends);
+				}
+				else
+				{
+					// no copy kept; wait out the deadline
+					request.resends = maxRetries;
+				}
+			}
+
+			continue;
+		}
+
+		request.state = RequestTimedOut;
+		request.deadline = now + finishedRequestLifetime;
+		requestTimeouts++;
+		sentMessages.remove(request.id);
+
+		if (request.onComplete)
+		{
+			int id = request.id;
+			request.id = 0;
+			request.onComplete(id, 0);
+		}
+	}
+}
+
+/// <summary>
+/// Gets zero or one available events for processing.
+/// </summary>
+/// <param name="shieldEvent">The address of ShieldEvent to populate.</param>
+/// <returns>true if an event was populated</returns>
+bool VirtualShield::getEvent(ShieldEvent* shieldEvent) {
+	pumpWrites();
+	expireRequests();
+
+	long elapsed = millis() - lastOpenRequest;
+	if (_VShieldSerial->available() == 0 && frame.pending() == 0 && elapsed > keepaliveInterval)
+	{
+		frame.write(AWAITING_MESSAGE);
+		lastOpenRequest = millis();
+
+		// against polling every requestInterval: the intervals this poll skipped
+		// (polls sooner, while a response is expected, are not counted either way)
+		keepalivesSent++;
+		if (elapsed > requestInterval)
+		{
+			keepalivesSaved += elapsed / requestInterval - 1;
+		}
+
+		keepaliveInterval = keepaliveInterval * 2 < maxKeepaliveInterval ? keepaliveInterval * 2 : maxKeepaliveInterval;
+	}
+
+	poll();
+
+	char kind;
+	int length;
+	char* message;
+
+	if (readyKind && isReadySystem)
+	{
+		kind = readyKind;
+		length = readyLength;
+		readyKind = 0;
+		message = swapReadBuffer();
+	}
+	else if (receiveQueueUsed > 0 && (freeReadBuffer() || (readBuffer && readBufferIndex == 0 && !readyKind)))
+	{
+		char header[3];
+		moveQueueBytes(header, 3, false);
+		kind = header[0];
+		length = (uint8_t)header[1] | ((uint8_t)header[2] << 8);
+
+		if (kind == CHUNKED_MESSAGE)
+		{
+			isChunkQueued = false;
+			onJsonStringReceived(chunkBuffer, shieldEvent);
+			return true;
+		}
+
+		// oldest first, into a free read buffer, or else the idle one, which is then handed over
+		message = freeReadBuffer();
+		if (!message)
+		{
+			message = swapReadBuffer();
+		}
+
+		moveQueueBytes(message, length, false);
+	}
+	else if (readyKind)
+	{
+		kind = readyKind;
+		length = readyLength;
+		readyKind = 0;
+		message = swapReadBuffer();
+	}
+	else
+	{
+		return false;
+	}
+
+	// the event's strings point into its buffer until every handler returned
+	unsigned int pin = 1u << ((message - readBuffers[0]) / maxReadBuffer);
+	pinnedReadBuffers |= pin;
+
+	if (kind == BINARY_MESSAGE)
+	{
+		onBinaryReceived(message, length, shieldEvent);
+	}
+	else
+	{
+		onTokensReceived(message, length, shieldEvent);
+	}
+
+	pinnedReadBuffers &= ~pin;
+	if (!readBuffer)
+	{
+		// reading paused while every buffer was pinned
+		readBuffer = message;
+		readBufferIndex = 0;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Sends the ping back form a ping request.
+/// </summary>
+/// <param name="shieldEvent">The shield event.</param>
+void VirtualShield::sendStart()
+{
+	if (batchId)
+	{
+		// a codec negotiated before the new handshake no longer applies
+		heldReplies = (heldReplies & ~HeldCodec) | HeldStart;
+		return;
+	}
+
+	EPtr none = EPtr(None);
+    EPtr eptrs[] = { EPtr(ACTION, START), EPtr(MemPtr, TYPE, "!"), EPtr(LEN, maxReadBuffer),
+		allowBinary ? EPtr(CODEC_KEY, CODEC_CBOR) : none,
+		// batches of messages may be sent once the remote device answers with BATCH
+		EPtr(BATCH_KEY, 1),
+		// the largest message that may be sent in chunks, -1 if any (streamed to onChunk)
+		onChunk ? EPtr(CHUNK_KEY, -1) : chunkBuffer ? EPtr(CHUNK_KEY, chunkBufferSize - 1) : none,
+		// the width of the checksum the remote device may add to its messages
+		allowChecksum ? EPtr(CHECKSUM_KEY, 8) : none };
+
+	// the handshake itself always goes out as JSON
+	codec = JsonWireCodec;
+	isBatchAccepted = false;
+	writeUrgent(eptrs, 7);
+}
+
+/// <summary>
+/// Sends the token dictionary, once the remote device asked for tokens (CODEC CborTokenWireCodec)
+/// and before the first message that uses them.
+/// </summary>
+void VirtualShield::sendDictionary()
+{
+	EPtr eptrs[] = { EPtr(ACTION, DICTIONARY_ACTION), EPtr(MemPtr, TYPE, "!"), EPtr(DICTIONARY_KEY, DICTIONARY) };
+	writeUrgent(eptrs, 3);
+}
+
+/// <summary>
+/// Switches to the encoding the remote device accepted (held until an open batch is committed,
+/// so a batch is never encoded two ways).
+/// </summary>
+/// <param name="accepted">The accepted encoding.</param>
+void VirtualShield::useCodec(WireCodec accepted)
+{
+	if (batchId)
+	{
+		heldCodec = accepted;
+		heldReplies |= HeldCodec;
+		return;
+	}
+
+	if (accepted == CborTokenWireCodec && codec != CborTokenWireCodec)
+	{
+		sendDictionary();
+	}
+
+	codec = accepted;
+}
+
+/// <summary>
+/// Sends the ping back form a ping request.
+/// </summary>
+/// <param name="shieldEvent">The shield event.</param>
+void VirtualShield::sendPingBack(ShieldEvent* /*shieldEvent*/)
+{
+	if (batchId)
+	{
+		heldReplies |= HeldPong;
+		return;
+	}
+
+	EPtr eptrs[] = { EPtr(ACTION, PONG), EPtr(MemPtr, TYPE, "!") };
+	writeUrgent(eptrs, 2);
+}
+
+/// <summary>
+/// Writes a system reply ahead of messages still queued (async), so a PONG never waits behind sensor traffic.
+/// </summary>
+/// <param name="values">The values.</param>
+/// <param name="count">The count of values.</param>
+void VirtualShield::writeUrgent(EPtr values[], int count)
+{
+	// the queued messages still drain last
+	int draining = drainingId;
+
+	isUrgentWrite = true;
+	writeAll(SERVICE_NAME_SERVICE, values, count);
+	isUrgentWrite = false;
+
+	if (draining)
+	{
+		drainingId = draining;
+	}
+}
+
+/// <summary>
+/// Event called when a valid json message was received. 
+/// Dispatches to added sensors that match the incoming Type.
+/// </summary>
+/// <param name="root">The root json object.</param>
+/// <param name="shieldEvent">The shield event.</param>
+void VirtualShield::onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) {
+	const char* sensorType = static_cast<const char *>(root["Type"]);
+
+	shieldEvent->resultId = 0;
+	shieldEvent->result = 0;
+	shieldEvent->action = 0;
+	shieldEvent->value = 0;
+
+	if (!(sensorType && sensorType[0] == SYSTEM_EVENT) && isDuplicate(root))
+	{
+		// an answer to a copy of a request already answered; nothing is updated from it
+		duplicatesSuppressed++;
+		shieldEvent->id = 0;
+		return;
+	}
+
+	// find the sensors first, so their fields are filled in the same pass over root as the event
+	Sensor** sensors = sensorType ? findSensors(sensorType[0]) : 0;
+	Sensor* sensor = sensors ? firstOfType(*sensors, sensorType[0]) : 0;
+
+	const char* tag = 0;
+	int id = 0;
+	int pid = 0;
+
+	for (JsonObject::iterator pair = root.begin(); pair != root.end(); ++pair)
+	{
+		const char* key = pair->key;
+		switch (key[0])
+		{
+		case 'T':
+			if (strcmp(key, "Tag") == 0) {
+				tag = static_cast<const char*>(pair->value);
+				continue;
+			}
+			break;
+		case 'I':
+			if (strcmp(key, "Id") == 0) {
+				id = static_cast<int>(pair->value);
+				continue;
+			}
+			break;
+		case 'P':
+			if (strcmp(key, "Pid") == 0) {
+				pid = static_cast<int>(pair->value);
+				continue;
+			}
+			break;
+		case 'R':
+			if (strcmp(key, "Result") == 0) {
+				shieldEvent->result = static_cast<const char*>(pair->value);
+				continue;
+			}
+			else if (strcmp(key, "ResultId") == 0) {
+				shieldEvent->resultId = static_cast<long>(pair->value);
+				continue;
+			}
+			break;
+		case 'A':
+			if (strcmp(key, "Action") == 0) {
+				shieldEvent->action = static_cast<const char*>(pair->value);
+				continue;
+			}
+			break;
+		case 'V':
+			if (strcmp(key, "Value") == 0) {
+				shieldEvent->value = static_cast<double>(pair->value);
+				continue;
+			}
+			break;
+		}
+
+		for (Sensor* listener = sensor; listener; listener = firstOfType(listener->nextSensor, sensor->sensorType))
+		{
+			listener->readField(key, pair->value);
+		}
+	}
+
+	// the dispatched event is tagged with its sensor type; the Tag goes to the sensors' recentEvent
+	shieldEvent->tag = sensorType;
+	shieldEvent->tagHash = hash(sensorType);
+	shieldEvent->id = pid ? pid : id;
+	shieldEvent->resultHash = hash(shieldEvent->result);
+	shieldEvent->actionHash = hash(shieldEvent->action);
+
+	unsigned int tagHash = sensor ? hash(tag) : 0;
+	for (Sensor* listener = sensor; listener; listener = firstOfType(listener->nextSensor, sensor->sensorType))
+	{
+		listener->recentEvent.tag = tag;
+		listener->recentEvent.tagHash = tagHash;
+		listener->recentEvent.action = shieldEvent->action;
+		listener->recentEvent.actionHash = shieldEvent->actionHash;
+		listener->recentEvent.resultHash = shieldEvent->resultHash;
+		listener->recentEvent.id = id;
+		listener->recentEvent.resultId = shieldEvent->resultId;
+		listener->recentEvent.result = shieldEvent->result;
+	}
+
+	if (sensorType) {
+		// special '!' Type which means remote device just connected/reconnected
+		if (sensorType[0] == SYSTEM_EVENT)
+		{
+			shieldEvent->cargo = &root;
+			bool refresh = false;
+			switch (shieldEvent->resultHash)
+			{
+			case PING_HASH:
+				sendPingBack(shieldEvent);
+				break;
+			case REFRESH_HASH:
+				refresh = true;
+				break;
+			case CONNECT_HASH:
+				refresh = true;
+				// a new connection negotiates checksums and batches again;
+				// the remote device may not have seen the handshake from begin()
+				isChecksumActive = false;
+				sendStart();
+
+				if (onConnect)
+				{
+					onConnect(shieldEvent);
+				}
+				break;
+			case SUSPEND_HASH:
+				if (onSuspend)
+				{
+					onSuspend(shieldEvent);
+				}
+				break;
+			case CHUNK_HASH:
+				// fragments are not events themselves
+				onChunkReceived(root, shieldEvent);
+				return;
+			case CODEC_HASH:
+				useCodec(allowBinary && (shieldEvent->value == CborWireCodec || shieldEvent->value == CborTokenWireCodec) ?
+					static_cast<WireCodec>(static_cast<int>(shieldEvent->value)) : JsonWireCodec);
+				break;
+			case BATCH_HASH:
+				isBatchAccepted = true;
+				break;
+			case RESUME_HASH:
+				refresh = true;
+				if (onResume)
+				{
+					onResume(shieldEvent);
+				}
+				break;
+			}
+
+			if (refresh)
+			{
+				// the remote device may have lost what it showed
+				clearOutputCache();
+			}
+
+			if (refresh && onRefresh)
+			{
+				onRefresh(shieldEvent);
+			}					  
+		} 
+		else if (sensor)
+		{
+			SensorEvent* sensorEvent = shieldEvent->shieldEventType == SensorShieldEventType ? static_cast<SensorEvent*>(shieldEvent) : 0;
+			for (Sensor* listener = sensor; listener; listener = firstOfType(listener->nextSensor, sensor->sensorType))
+			{
+				// each listener (and its onEvent) sees itself as the sensor of the event
+				if (sensorEvent)
+				{
+					sensorEvent->sensor = listener;
+				}
+
+				listener->onJsonReceived(root, shieldEvent);
+			}
+
+			if (sensorEvent)
+			{
+				sensorEvent->sensor = sensor;
+			}
+		}
+	}
+
+	completeRequests(shieldEvent);
+
+	if (onEvent)
+	{
+		onEvent(shieldEvent);
+	}
+}
+
+/// <summary>
+/// Event callback for when a full json string is received.
+/// </summary>
+/// <param name="json">The json string.</param>
+/// <param name="shieldEvent">The shield event to populate.</param>
+void VirtualShield::onJsonStringReceived(char* json, ShieldEvent* shieldEvent) {
+    StaticJsonBuffer<maxJsonReadBuffer> jsonBuffer;
+	JsonObject& root = jsonBuffer.parseObject(json);
+	if (root.success()) {
+		onJsonReceived(root, shieldEvent);
+	} 
+	else
+	{
+		//Serial.print("FAILED");
+	}
+}
+
+/// <summary>
+/// Event callback for when a full binary (CBOR) frame is received. The frame is decoded in place.
+/// </summary>
+/// <param name="buffer">The buffer holding the frame payload.</param>
+/// <param name="length">The length of the payload.</param>
+/// <param name="shieldEvent">The shield event to populate.</param>
+void VirtualShield::onBinaryReceived(char* buffer, int length, ShieldEvent* shieldEvent) {
+    StaticJsonBuffer<maxJsonReadBuffer> jsonBuffer;
+	JsonObject& root = jsonBuffer.createObject();
+	if (Cbor::decodeObject(buffer, length, root)) {
+		onJsonReceived(root, shieldEvent);
+	}
+}
+
+/// <summary>
+/// Event callback for when a full json message was read by the tokenizer. The object refers to the tokens in place.
+/// </summary>
+/// <param name="tokens">The buffer holding the tokens (kind, key, 0, value, 0 per pair).</param>
+/// <param name="length">The length of the tokens.</param>
+/// <param name="shieldEvent">The shield event to populate.</param>
+void VirtualShield::onTokensReceived(char* tokens, int length, ShieldEvent* shieldEvent) {
+    StaticJsonBuffer<maxJsonReadBuffer> jsonBuffer;
+	JsonObject& root = jsonBuffer.createObject();
+
+	const char* scanner = tokens;
+	const char* end = tokens + length;
+	while (scanner < end)
+	{
+		char kind = *scanner++;
+		const char* key = scanner;
+		scanner += strlen(scanner) + 1;
+		const char* value = scanner;
+		scanner += strlen(scanner) + 1;
+
+		if (kind == TEXT_TOKEN)
+		{
+			root.set(key, value);
+		}
+		else
+		{
+			root.set(key, RawJson(value));
+		}
+	}
+
+	onJsonReceived(root, shieldEvent);
+}
+
+/// <summary>
+/// Sets the buffer that large messages sent in chunks are reassembled into, then dispatched like any other message.
+/// Events of a reassembled message refer to the buffer until the next one. Set before begin().
+/// </summary>
+/// <param name="buffer">The buffer.</param>
+/// <param name="size">The size of the buffer.</param>
+void VirtualShield::setChunkBuffer(char* buffer, int size)
+{
+	chunkBuffer = buffer;
+	chunkBufferSize = size;
+	chunkLength = 0;
+	chunkNext = 0;
+}
+
+/// <summary>
+/// Event callback for a fragment of a large message:
+/// {'Type':'!','Result':'CHUNK','Id':id,'Value':sequence,'Action':'MORE' or 'LAST','Data':'...'}
+/// Fragments are streamed to onChunk, or appended to the chunk buffer until the last one. The reassembled message is
+/// then dispatched in its turn, after the messages still queued from before it.
+/// Out of sequence fragments, a full buffer, or a new message before the last one was dispatched drop the message
+/// (counted in droppedChunks).
+/// </summary>
+/// <param name="root">The fragment.</param>
+/// <param name="shieldEvent">The shield event.</param>
+void VirtualShield::onChunkReceived(JsonObject& root, ShieldEvent* shieldEvent)
+{
+	const char* data = static_cast<const char*>(root["Data"]);
+	int length = data ? strlen(data) : 0;
+	int sequence = static_cast<int>(shieldEvent->value);
+	bool isLast = shieldEvent->actionHash == LAST_HASH;
+
+	if (sequence == 0 && isChunkQueued)
+	{
+		// the last reassembled message has not been dispatched yet
+		droppedChunks++;
+		chunkNext = -1;
+		return;
+	}
+
+	if (sequence == 0)
+	{
+		chunkId = shieldEvent->id;
+		chunkLength = 0;
+		chunkNext = 0;
+	}
+
+	if (shieldEvent->id != chunkId || sequence != chunkNext)
+	{
+		// lost a fragment - wait for the next message
+		droppedChunks++;
+		chunkNext = -1;
+		return;
+	}
+
+	chunkNext++;
+
+	if (onChunk)
+	{
+		onChunk(chunkId, data, length, isLast);
+		return;
+	}
+
+	if (!chunkBuffer)
+	{
+		return;
+	}
+
+	if (chunkLength + length >= chunkBufferSize)
+	{
+		droppedChunks++;
+		chunkNext = -1;
+		return;
+	}
+
+	memcpy(chunkBuffer + chunkLength, data, length);
+	chunkLength += length;
+
+	if (isLast)
+	{
+		chunkBuffer[chunkLength] = 0;
+		chunkNext = -1;
+
+		if (receiveQueueUsed > 0)
+		{
+			// messages received before the chunks are still queued; take a turn behind them
+			if (receiveQueueUsed + 3 <= receiveQueueSize)
+			{
+				char header[3] = { CHUNKED_MESSAGE, 0, 0 };
+				moveQueueBytes(header, 3, true);
+				isChunkQueued = true;
+				return;
+			}
+
+			receiveQueueOverflows++;
+		}
+
+		onJsonStringReceived(chunkBuffer, shieldEvent);
+	}
+}
+
+/// <summary>
+/// Event callback for when a full string is received.
+/// </summary>
+/// <param name="buffer">The buffer.</param>
+/// <param name="length">The length.</param>
+/// <param name="shieldEvent">The shield event.</param>
+void VirtualShield::onStringReceived(char* buffer, int /*length*/, ShieldEvent* shieldEvent) {
+	// parsed in place; the event strings point into the buffer until the message after next is read
+	onJsonStringReceived(buffer, shieldEvent);
+}
+
+/// <summary>
+/// Receives events as long as they exist, or until an optional timeout occurs.
 /// </summary>
 /// <param name="watchForId">An id to return true if found. Otherwise true is returned for any events processed.</param>
 /// <param name="timeout">The timeout in milliseconds.</param>
@@ -374,10 +2003,12 @@ void VirtualShield::onStringReceived(char* buffer, int length, ShieldEvent* shie
 bool VirtualShield::checkSensors(int watchForId, long timeout, int watchForResultId) {
 	bool hadEvents = false;
 
-	long started = millis();
+	unsigned long started = millis();
 	recentEventErrorId = 0;
-	while (getEvent(&recentEvent) && (timeout == 0 || started+timeout <= millis()) ) {
-		hadEvents = (watchForId == 0 || recentEvent.id == watchForId) && (watchForResultId == -1 || recentEvent.resultId == watchForResultId);
+	while ((timeout == 0 || millis() - started < (unsigned long)timeout) && getEvent(&recentEvent)) {
+		// a later event must not hide the one watched for
+		hadEvents = hadEvents ||
+			((watchForId == 0 || recentEvent.id == watchForId) && (watchForResultId == -1 || recentEvent.resultId == watchForResultId));
 	}
 
 	return hadEvents;
@@ -391,7 +2022,7 @@ bool VirtualShield::checkSensors(int watchForId, long timeout, int watchForResul
 /// <param name="text">The text.</param>
 void VirtualShield::write(const char* text)
 {
-	_VShieldSerial->write(text);
+	frame.write(text);
 }
 
 /// <summary>
@@ -400,7 +2031,7 @@ void VirtualShield::write(const char* text)
 /// <param name="serviceName">Name of the service.</param>
 /// <returns>int.</returns>
 int VirtualShield::writeAll(const char* serviceName)  {
-	byte id = beginWrite(serviceName);
+	int id = beginWrite(serviceName);
 	if (endWrite() != 0) return SERIAL_ERROR;
 
 	return id;
@@ -419,16 +2050,114 @@ int VirtualShield::waitFor(int id, long timeout, bool asSuccess, int resultId)
 		return id;
 	}
 
-	timeout = timeout + millis();
-
 	bool found = false;
-	while (!found && millis() < timeout) {
-		found = checkSensors(id, 0, resultId);
+	if (maxRetries > 0 && track(id, 0, timeout, resultId) == id)
+	{
+		// tracked, so a lost message is sent again while waiting
+		while (!found && requestState(id) == RequestPending) {
+			found = checkSensors(id, 0, resultId);
+		}
+
+		untrack(id);
+	}
+	else
+	{
+		unsigned long deadline = millis() + timeout;
+		while (!found && static_cast<long>(millis() - deadline) < 0) {
+			found = checkSensors(id, 0, resultId);
+		}
 	}
 
 	return found ? (asSuccess && id < 0 ? 0 : id) : 0;
 }
 
+/// <summary>
+/// Returns true if the event answers a request: a sensor reading or a Result. An Action without a Result or
+/// ResultId (a button pressed) is raised by the user, and only carries the id of the request that created it.
+/// </summary>
+/// <param name="shieldEvent">The event.</param>
+static bool isResponse(ShieldEvent* shieldEvent)
+{
+	return shieldEvent->id > 0 && (!shieldEvent->action || shieldEvent->result || shieldEvent->resultId != 0);
+}
+
+/// <summary>
+/// Blocks until every id has been answered, or the timeout. Responses are matched in one pass over incoming
+/// events, so the wait is as long as the slowest response.
+/// </summary>
+/// <param name="ids">The ids, up to 32. Ids that are errors (negative) are not waited for.</param>
+/// <param name="count">The count of ids.</param>
+/// <param name="timeout">The timeout in milliseconds.</param>
+/// <returns>The count of ids answered, which is the count of ids waited for if all were; SERIAL_ERROR for more
+/// than 32 ids.</returns>
+int VirtualShield::waitForAll(const int ids[], int count, long timeout)
+{
+	const int maxIds = 32;
+	unsigned long answered = 0;
+	int answeredCount = 0;
+	int remaining = 0;
+	if (count > maxIds)
+	{
+		return SERIAL_ERROR;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		remaining += ids[i] > 0;
+	}
+
+	unsigned long started = millis();
+	while (remaining > 0 && millis() - started < (unsigned long)timeout)
+	{
+		if (!getEvent(&recentEvent) || !isResponse(&recentEvent))
+		{
+			continue;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			unsigned long bit = 1UL << i;
+			if (ids[i] > 0 && ids[i] == recentEvent.id && !(answered & bit))
+			{
+				answered |= bit;
+				answeredCount++;
+				remaining--;
+			}
+		}
+	}
+
+	return answeredCount;
+}
+
+/// <summary>
+/// Blocks until any of the ids is answered, or the timeout.
+/// </summary>
+/// <param name="ids">The ids.</param>
+/// <param name="count">The count of ids.</param>
+/// <param name="timeout">The timeout in milliseconds.</param>
+/// <returns>The id answered first, or zero if none.</returns>
+int VirtualShield::waitForAny(const int ids[], int count, long timeout)
+{
+	unsigned long started = millis();
+	while (millis() - started < (unsigned long)timeout)
+	{
+		if (!getEvent(&recentEvent) || !isResponse(&recentEvent))
+		{
+			continue;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			if (ids[i] > 0 && ids[i] == recentEvent.id)
+			{
+				return ids[i];
+			}
+		}
+	}
+
+	return 0;
+}
+
 /// <summary>
 /// Returns true
 /// </summary>
@@ -446,52 +2175,349 @@ bool VirtualShield::hasError(ShieldEvent* shieldEvent) {
 /// <returns>The new id of the message or a negative error..</returns>
 int VirtualShield::beginWrite(const char* serviceName)  
 {
-	int id = nextId++; 
+	int id = nextId++;
+	lastWriteId = id; 
 
 	if (nextId < 0) //let's stay positive
 	{
 		nextId = 1;
 	}
 
-	if (sendFlashStringOnSerial(MESSAGE_SERVICE_START) != 0) return SERIAL_ERROR;
+	if (batchId)
+	{
+		// already inside the open batch frame; only separate from the previous message
+		if (batchCount++ > 0 && codec == JsonWireCodec)
+		{
+			frame.write(',');
+		}
+	}
+	else
+	{
+		frame.begin(_VShieldSerial, isUrgentWrite);
+
+		if (maxRetries > 0 && !isUrgentWrite)
+		{
+			// keep a copy in case it must be sent again
+			sentMessages.begin(id);
+			frame.capture = &sentMessages;
+		}
+	}
+
+	if (codec != JsonWireCodec)
+	{
+		Cbor::writeIndefinite(frame, CBOR_MAP);
+		writeCborKey(SERVICE_KEY);
+		writeCborKey(serviceName);
+		writeCborKey(ID_KEY);
+		Cbor::writeInt(frame, id);
+		return id;
+	}
+
+	if (sendFlashFragment(MESSAGE_SERVICE_START) != 0) return SERIAL_ERROR;
 	if (sendFlashStringOnSerial(serviceName) != 0) return SERIAL_ERROR;
-	if (sendFlashStringOnSerial(MESSAGE_SERVICE_TO_ID) != 0) return SERIAL_ERROR;
-	_VShieldSerial->print(id);
-#ifdef debugSerial
-	Serial.print(id);
-#endif
+	if (sendFlashFragment(MESSAGE_SERVICE_TO_ID) != 0) return SERIAL_ERROR;
+	frame.print(id);
+
+	return id;
+}
+
+/// <summary>
+/// Writes all EPtr values to the communication channel.
+/// </summary>
+/// <param name="serviceName">Name of the service.</param>
+/// <param name="values">The values.</param>
+/// <param name="count">The count of values.</param>
+/// <returns>The new id of the message or a negative error.</returns>
+int VirtualShield::writeAll(const char* serviceName, EPtr values[], int count, Attr extraAttributes[], int extraAttributeCount, const char sensorType) {
+	int id = beginWrite(serviceName);
+
+	for (int i = 0; i < count; i++)
+	{
+		write(values[i]);
+	}
+
+	if (sensorType)
+	{
+		write(EPtr(TYPE, sensorType));
+	}
+
+	for (int i = 0; i < extraAttributeCount; i++)
+	{
+		write(extraAttributes[i]);
+	}
+
+	if (endWrite() != 0) return SERIAL_ERROR;
+
+	return id;
+}
+
+/// <summary>
+/// Writes all EPtr values to the communication channel, unless they match the last message written for the cache key
+/// (only when the output cache is enabled).
+/// </summary>
+/// <param name="cacheKey">The cache key, identifying what the message updates (see cacheKey()).</param>
+/// <param name="serviceName">Name of the service.</param>
+/// <param name="values">The values.</param>
+/// <param name="count">The count of values.</param>
+/// <returns>The new id of the message, the id of the identical cached message, or a negative error.</returns>
+int VirtualShield::writeCached(unsigned int cacheKey, const char* serviceName, EPtr values[], int count, Attr extraAttributes[], int extraAttributeCount, const char sensorType)
+{
+	if (!allowOutputCache)
+	{
+		return writeAll(serviceName, values, count, extraAttributes, extraAttributeCount, sensorType);
+	}
+
+	unsigned int payload = hashPayload(values, count, hashPayload(extraAttributes, extraAttributeCount, sensorType));
+	int id = findCached(cacheKey, payload);
+	if (id == 0)
+	{
+		id = writeAll(serviceName, values, count, extraAttributes, extraAttributeCount, sensorType);
+		rememberCached(cacheKey, payload, id);
+	}
+
+	return id;
+}
+
+/// <summary>
+/// Finds the message last written for the cache key, when it had the same payload.
+/// </summary>
+/// <param name="cacheKey">The cache key.</param>
+/// <param name="payload">The hash of the payload (see hashPayload()).</param>
+/// <returns>The id of the identical cached message, or zero if the message must be sent.</returns>
+int VirtualShield::findCached(unsigned int cacheKey, unsigned int payload)
+{
+	OutputCacheEntry& entry = outputCache[cacheKey % outputCacheSize];
+
+	if (entry.id > 0 && entry.key == cacheKey && entry.payload == payload)
+	{
+		outputCacheHits++;
+		outputCacheHitId = entry.id;
+		return entry.id;
+	}
+
+	outputCacheMisses++;
+	return 0;
+}
+
+/// <summary>
+/// Remembers the message just written for the cache key.
+/// </summary>
+/// <param name="cacheKey">The cache key.</param>
+/// <param name="payload">The hash of the payload.</param>
+/// <param name="id">The id of the message, or a negative error (never matched).</param>
+void VirtualShield::rememberCached(unsigned int cacheKey, unsigned int payload, int id)
+{
+	OutputCacheEntry& entry = outputCache[cacheKey % outputCacheSize];
+	entry.key = cacheKey;
+	entry.payload = payload;
+	entry.id = id;
+}
+
+/// <summary>
+/// The frame the values of a fixed-shape command are written to.
+/// </summary>
+Print& VirtualShield::shapeOutput()
+{
+	return frame;
+}
+
+/// <summary>
+/// Begins a fixed-shape command: writes the service, the id, the action and opens the list of a list shape.
+/// </summary>
+/// <param name="serviceName">Name of the service.</param>
+/// <param name="shape">The flash shape.</param>
+/// <returns>The id of the message.</returns>
+int VirtualShield::beginShape(const char* serviceName, const Shape* shape)
+{
+	int id = beginWrite(serviceName);
+
+	const char* action = static_cast<const char*>(pgm_read_ptr(&shape->action));
+	if (action)
+	{
+		sendFlashFragment(MESSAGE_SEPARATOR);
+		sendFlashFragment(ACTION);
+		sendFlashFragment(MESSAGE_PAIR_SEPARATOR);
+		sendFlashFragment(MESSAGE_QUOTE);
+		sendFlashStringOnSerial(action);
+		sendFlashFragment(MESSAGE_QUOTE);
+	}
+
+	const char* list = static_cast<const char*>(pgm_read_ptr(&shape->list));
+	if (list)
+	{
+		sendFlashFragment(MESSAGE_SEPARATOR);
+		sendFlashStringOnSerial(list);
+		sendFlashFragment(MESSAGE_PAIR_SEPARATOR);
+		sendFlashFragment(ARRAY_START);
+	}
+
+	return id;
+}
+
+/// <summary>
+/// Writes the key of a value of a fixed-shape command.
+/// </summary>
+/// <param name="shape">The flash shape.</param>
+/// <param name="index">The index of the value.</param>
+/// <param name="sensorType">The sensor type, keying the first value of a list shape.</param>
+void VirtualShield::writeShapeKey(const Shape* shape, int index, char sensorType) const
+{
+	if (index == 0 && pgm_read_ptr(&shape->list))
+	{
+		frame.write('\'');
+		frame.write(sensorType);
+	}
+	else
+	{
+		sendFlashFragment(MESSAGE_SEPARATOR);
+		sendFlashStringOnSerial(static_cast<const char*>(pgm_read_ptr(&shape->keys[index])));
+	}
+
+	sendFlashFragment(MESSAGE_PAIR_SEPARATOR);
+}
+
+/// <summary>
+/// Ends a fixed-shape command: closes its list or adds the sensor type, then appends the options.
+/// </summary>
+/// <param name="shape">The flash shape.</param>
+/// <param name="sensorType">The sensor type, or zero.</param>
+/// <param name="options">The optional values (None ones are skipped).</param>
+/// <param name="optionCount">The count of options.</param>
+/// <returns>Zero if no error, negative if an error.</returns>
+int VirtualShield::endShape(const Shape* shape, char sensorType, EPtr options[], int optionCount)
+{
+	if (pgm_read_ptr(&shape->list))
+	{
+		sendFlashFragment(ARRAY_END);
+	}
+	else if (sensorType)
+	{
+		write(EPtr(TYPE, sensorType));
+	}
+
+	for (int i = 0; i < optionCount; i++)
+	{
+		write(options[i]);
+	}
+
+	return endWrite();
+}
+
+/// <summary>
+/// Prints a value of a fixed-shape command. Text is quoted and escaped.
+/// </summary>
+/// <param name="out">The frame, or a PayloadHash.</param>
+/// <param name="value">The value.</param>
+void VirtualShield::printShapeValue(Print& out, unsigned int value)
+{
+	out.print(value);
+}
+
+void VirtualShield::printShapeValue(Print& out, int value)
+{
+	out.print(value);
+}
+
+void VirtualShield::printShapeValue(Print& out, long value)
+{
+	printFixed(out, value, 0);
+}
+
+void VirtualShield::printShapeValue(Print& out, double value)
+{
+	printDouble(out, value, defaultPrecision);
+}
+
+void VirtualShield::printShapeValue(Print& out, const char* text)
+{
+	out.write('\'');
+	while (*text)
+	{
+		if (*text == '\'' || *text == '\\')
+		{
+			out.write('\\');
+		}
+
+		out.write(*text++);
+	}
+
+	out.write('\'');
+}
+
+/// <summary>
+/// Forgets every message remembered by the output cache, so the next ones are sent.
+/// </summary>
+void VirtualShield::clearOutputCache()
+{
+	if (outputCache)
+	{
+		memset(outputCache, 0, outputCacheSize * sizeof(OutputCacheEntry));
+	}
+
+	outputCacheHitId = 0;
+}
 
-	return id;
+/// <summary>
+/// Sets the entries of the output cache, or none to turn it off: writeCached() skips sending a message identical
+/// to the last one sent for its key. Keys share an entry when there are fewer entries than lines and shapes updated.
+/// </summary>
+/// <param name="entries">The entries.</param>
+/// <param name="count">The count of entries.</param>
+void VirtualShield::setOutputCache(OutputCacheEntry* entries, int count)
+{
+	outputCache = entries;
+	outputCacheSize = entries ? count : 0;
+	allowOutputCache = outputCacheSize > 0;
+	clearOutputCache();
 }
 
 /// <summary>
-/// Writes all EPtr values to the communication channel.
+/// Builds an output cache key from a service and what the message updates on it (line, position or tag).
 /// </summary>
 /// <param name="serviceName">Name of the service.</param>
+/// <param name="x">The x position, or zero.</param>
+/// <param name="y">The y position or line.</param>
+/// <param name="tag">The tag, or null.</param>
+/// <returns>The cache key.</returns>
+unsigned int VirtualShield::cacheKey(const char* serviceName, unsigned int x, unsigned int y, const char* tag)
+{
+	// service names are flash (PROGMEM) constants, so their address identifies them
+	unsigned int key = (reinterpret_cast<uintptr_t>(serviceName) * 101 + x) * 101 + y;
+	return tag ? hash(tag, -1, key) : key;
+}
+
+/// <summary>
+/// Hashes the keys and printed values of EPtrs, without the message id.
+/// </summary>
 /// <param name="values">The values.</param>
 /// <param name="count">The count of values.</param>
-/// <returns>The new id of the message or a negative error.</returns>
-int VirtualShield::writeAll(const char* serviceName, EPtr values[], int count, Attr extraAttributes[], int extraAttributeCount, const char sensorType) {
-	byte id = beginWrite(serviceName);
-
-	for (size_t i = 0; i < count; i++)
+/// <param name="seed">The seed.</param>
+/// <returns>The hash.</returns>
+unsigned int VirtualShield::hashPayload(EPtr values[], int count, unsigned int seed)
+{
+	PayloadHash out(seed);
+	for (int i = 0; i < count; i++)
 	{
-		write(values[i]);
-	}
+		EPtr& eptr = values[i];
+		if (eptr.ptrType == None)
+		{
+			continue;
+		}
 
-	if (sensorType)
-	{
-		write(EPtr(TYPE, sensorType));
-	}
+		out.value = out.value * 101 + reinterpret_cast<uintptr_t>(eptr.key);
+		out.write(static_cast<uint8_t>(eptr.ptrType));
 
-	for (size_t i = 0; i < extraAttributeCount; i++)
-	{
-		write(extraAttributes[i]);
+		if (eptr.ptrType == Format)
+		{
+			printFormat(out, eptr);
+		}
+		else
+		{
+			printValue(out, eptr);
+		}
 	}
 
-	if (endWrite() != 0) return SERIAL_ERROR;
-
-	return id;
+	return out.value;
 }
 
 /// <summary>
@@ -506,46 +2532,64 @@ int VirtualShield::write(EPtr eptr)	const
 		return SERIAL_SUCCESS;
 	}
 
+	if (codec != JsonWireCodec)
+	{
+		if (eptr.ptrType == ArrayEnd)
+		{
+			Cbor::writeBreak(frame);
+			Cbor::writeBreak(frame);
+			return SERIAL_SUCCESS;
+		}
+
+		if (eptr.keyIsMem)
+		{
+			Cbor::writeText(frame, eptr.key, strlen(eptr.key));
+		}
+		else
+		{
+			writeCborKey(eptr.key);
+		}
+
+		return writeCborValue(eptr);
+	}
+
 	if (eptr.ptrType == ArrayEnd)
 	{
-		if (sendFlashStringOnSerial(ARRAY_END) != 0) return SERIAL_ERROR;
+		if (sendFlashFragment(ARRAY_END) != 0) return SERIAL_ERROR;
 		return SERIAL_SUCCESS;
 	}
 
 	if (isArrayStarted)
 	{
-		if (sendFlashStringOnSerial(MESSAGE_QUOTE) != 0) return SERIAL_ERROR;
+		if (sendFlashFragment(MESSAGE_QUOTE) != 0) return SERIAL_ERROR;
 		isArrayStarted = false;
 	} 
 	else
 	{
-		if (sendFlashStringOnSerial(MESSAGE_SEPARATOR) != 0) return SERIAL_ERROR;
+		if (sendFlashFragment(MESSAGE_SEPARATOR) != 0) return SERIAL_ERROR;
 	}
 
 	if (eptr.keyIsMem)
 	{
-		_VShieldSerial->print(eptr.key);
-#ifdef debugSerial
-		Serial.print(eptr.key);
-#endif			
+		frame.print(eptr.key);
 	} 
 	else
 	{
 		if (sendFlashStringOnSerial(eptr.key) != 0) return SERIAL_ERROR;
 	}
 
-	if (sendFlashStringOnSerial(MESSAGE_PAIR_SEPARATOR) != 0) return SERIAL_ERROR;
+	if (sendFlashFragment(MESSAGE_PAIR_SEPARATOR) != 0) return SERIAL_ERROR;
 
 	if (eptr.asText)
 	{
-		if (sendFlashStringOnSerial(MESSAGE_QUOTE) != 0) return SERIAL_ERROR;
+		if (sendFlashFragment(MESSAGE_QUOTE) != 0) return SERIAL_ERROR;
 	}
 
 	writeValue(eptr);
 
 	if (eptr.asText)
 	{
-		if (sendFlashStringOnSerial(MESSAGE_QUOTE) != 0) return SERIAL_ERROR;
+		if (sendFlashFragment(MESSAGE_QUOTE) != 0) return SERIAL_ERROR;
 	}
 
 	return SERIAL_SUCCESS;
@@ -560,7 +2604,7 @@ int VirtualShield::writeValue(EPtr eptr, int start) const
 	switch (eptr.ptrType)
 	{
 	case ArrayStart:
-		result = sendFlashStringOnSerial(ARRAY_START);
+		result = sendFlashFragment(ARRAY_START);
 		isArrayStarted = true;
 		break;
 	case ProgPtr:
@@ -573,55 +2617,22 @@ int VirtualShield::writeValue(EPtr eptr, int start) const
 		int count = eptr.length;
 		while (count == -1 ? scanner[0] : count-- > 0) {
 			if (!eptr.encoded && (scanner[0] == '\'' || scanner[0] == '\\' )) {
-				_VShieldSerial->write('\\');
-#ifdef debugSerial
-				Serial.write('\\');
-#endif
+				frame.write('\\');
 			}
-			_VShieldSerial->write(scanner[0]);
-#ifdef debugSerial
-			Serial.write(scanner[0]);
-#endif
+			frame.write(scanner[0]);
 			scanner++;
 		}
 
 		break;
 	}
 	case Char:
-		_VShieldSerial->print(eptr.charValue);
-#ifdef debugSerial
-		Serial.print(eptr.charValue);
-#endif
-		break;
 	case Int:
-		_VShieldSerial->print(eptr.intValue);
-#ifdef debugSerial
-		Serial.print(eptr.intValue);
-#endif
-		break;
 	case Uint:
-		_VShieldSerial->print(eptr.uintValue);
-#ifdef debugSerial
-		Serial.print(eptr.uintValue);
-#endif
-		break;
 	case Long:
-		_VShieldSerial->print(eptr.longValue);
-#ifdef debugSerial
-		Serial.print(eptr.longValue);
-#endif
-		break;
 	case Double:
-		_VShieldSerial->print(eptr.doubleValue, 4);
-#ifdef debugSerial
-		Serial.print(eptr.doubleValue, 4);
-#endif
-		break;
 	case Bool:
-		_VShieldSerial->print(eptr.boolValue);
-#ifdef debugSerial
-		Serial.print((bool)eptr.doubleValue);
-#endif
+	case Fixed:
+		printValue(frame, eptr);
 		break;
 	case Format:
 		//Serial.print(eptr.eptrs[1].doubleValue);
@@ -649,6 +2660,301 @@ int VirtualShield::writeValue(EPtr eptr, int start) const
 	return result;
 }
 
+/// <summary>
+/// Writes the value of the specified eptr in the compact binary (CBOR) encoding.
+/// </summary>
+/// <param name="eptr">The eptr.</param>
+/// <returns>Zero if no error, negative if an error.</returns>
+int VirtualShield::writeCborValue(EPtr eptr) const
+{
+	switch (eptr.ptrType)
+	{
+	case ArrayStart:
+		Cbor::writeIndefinite(frame, CBOR_ARRAY);
+		Cbor::writeIndefinite(frame, CBOR_MAP);
+		break;
+	case ProgPtr:
+	{
+		size_t length = strlen_P(eptr.value);
+		Cbor::writeHead(frame, CBOR_TEXT, length);
+		sendFlashBlock(eptr.value, length);
+		break;
+	}
+	case MemPtr:
+		Cbor::writeText(frame, eptr.value, eptr.length == DEFAULT_LENGTH ? strlen(eptr.value) : eptr.length);
+		break;
+	case Format:
+	{
+		CborText text(frame);
+		printFormat(text, eptr);
+		text.end();
+		break;
+	}
+	case Char:
+	case Int:
+	case Uint:
+	case Long:
+	case Double:
+	case Bool:
+	case Fixed:
+		if (eptr.asText)
+		{
+			CborText text(frame);
+			printValue(text, eptr);
+			text.end();
+		}
+		else if (eptr.ptrType == Uint)
+		{
+			Cbor::writeHead(frame, CBOR_UINT, eptr.uintValue);
+		}
+		else if (eptr.ptrType == Double)
+		{
+			Cbor::writeFloat(frame, eptr.doubleValue);
+		}
+		else if (eptr.ptrType == Bool)
+		{
+			Cbor::writeBool(frame, eptr.boolValue);
+		}
+		else if (eptr.ptrType == Fixed && eptr.length > 0)
+		{
+			double value = eptr.longValue;
+			for (int decimals = eptr.length; decimals > 0; decimals -= maxPrecision)
+			{
+				value /= powersOfTen[min(decimals, maxPrecision)];
+			}
+
+			Cbor::writeFloat(frame, value);
+		}
+		else
+		{
+			Cbor::writeInt(frame, eptr.ptrType == Long || eptr.ptrType == Fixed ? eptr.longValue : eptr.intValue);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return SERIAL_SUCCESS;
+}
+
+/// <summary>
+/// Writes a flash (PROGMEM) key or service name, as its dictionary token when the remote device accepted tokens.
+/// </summary>
+/// <param name="flashKey">The flash (PROGMEM) key.</param>
+void VirtualShield::writeCborKey(const char* flashKey) const
+{
+	if (codec == CborTokenWireCodec)
+	{
+		int token = findToken(flashKey);
+		if (token >= 0)
+		{
+			Cbor::writeHead(frame, CBOR_UINT, token);
+			return;
+		}
+	}
+
+	size_t length = strlen_P(flashKey);
+	Cbor::writeHead(frame, CBOR_TEXT, length);
+	sendFlashBlock(flashKey, length);
+}
+
+/// <summary>
+/// Finds the dictionary token of a flash (PROGMEM) key. Recent keys are remembered by address.
+/// </summary>
+/// <param name="flashKey">The flash (PROGMEM) key.</param>
+/// <returns>The token, or -1 if the key is not in the dictionary.</returns>
+int VirtualShield::findToken(const char* flashKey)
+{
+	const int slot = (reinterpret_cast<uintptr_t>(flashKey) >> 1) % tokenCacheSize;
+	if (tokenCacheKeys[slot] == flashKey)
+	{
+		return tokenCacheValues[slot];
+	}
+
+	int token = 0;
+	const char* entry = DICTIONARY;
+	unsigned char entryChar = pgm_read_byte_near(entry);
+
+	while (true)
+	{
+		const char* key = flashKey;
+		unsigned char keyChar = pgm_read_byte_near(key);
+		while (entryChar == keyChar && entryChar && entryChar != '|')
+		{
+			entryChar = pgm_read_byte_near(++entry);
+			keyChar = pgm_read_byte_near(++key);
+		}
+
+		if (keyChar == 0 && (entryChar == '|' || entryChar == 0))
+		{
+			break;
+		}
+
+		while (entryChar && entryChar != '|')
+		{
+			entryChar = pgm_read_byte_near(++entry);
+		}
+
+		if (!entryChar)
+		{
+			token = -1;
+			break;
+		}
+
+		entryChar = pgm_read_byte_near(++entry);
+		token++;
+	}
+
+	tokenCacheKeys[slot] = flashKey;
+	tokenCacheValues[slot] = token;
+	return token;
+}
+
+/// <summary>
+/// Prints the plain text of a single value, without quoting or escaping.
+/// </summary>
+/// <param name="out">The output.</param>
+/// <param name="eptr">The eptr.</param>
+void VirtualShield::printValue(Print& out, EPtr eptr)
+{
+	switch (eptr.ptrType)
+	{
+	case ProgPtr:
+	{
+		const char* scanner = eptr.value;
+		unsigned char dataChar;
+		while ((dataChar = pgm_read_byte_near(scanner++)) != 0)
+		{
+			out.write(dataChar);
+		}
+
+		break;
+	}
+	case MemPtr:
+		out.write(eptr.value, eptr.length == DEFAULT_LENGTH ? strlen(eptr.value) : eptr.length);
+		break;
+	case Char:
+		out.print(eptr.charValue);
+		break;
+	case Int:
+		printFixed(out, eptr.intValue, 0);
+		break;
+	case Uint:
+		out.print(eptr.uintValue);
+		break;
+	case Long:
+		printFixed(out, eptr.longValue, 0);
+		break;
+	case Fixed:
+		printFixed(out, eptr.longValue, eptr.length);
+		break;
+	case Double:
+		printDouble(out, eptr.doubleValue, eptr.length < 0 ? defaultPrecision : eptr.length);
+		break;
+	case Bool:
+		out.print(eptr.boolValue);
+		break;
+	default:
+		break;
+	}
+}
+
+/// <summary>
+/// Prints an integer scaled by 10^decimals as a decimal number, dropping trailing zeros of the fraction.
+/// Digits are produced with integer division only and sent with a single write. More than maxPrecision decimals
+/// are rounded off, so the digits always fit the text.
+/// </summary>
+/// <param name="out">The output.</param>
+/// <param name="value">The scaled value (i.e. 1250 with 3 decimals is 1.25).</param>
+/// <param name="decimals">The count of decimals in the value.</param>
+void VirtualShield::printFixed(Print& out, long value, int decimals)
+{
+	char text[13];
+	char* end = text + sizeof(text);
+	char* scanner = end;
+
+	unsigned long magnitude = value < 0 ? -static_cast<unsigned long>(value) : value;
+	while (decimals > maxPrecision)
+	{
+		magnitude = (magnitude + (decimals == maxPrecision + 1 ? 5 : 0)) / 10;
+		decimals--;
+	}
+
+	bool negative = value < 0 && magnitude > 0;
+	while (decimals > 0 && magnitude % 10 == 0)
+	{
+		magnitude /= 10;
+		decimals--;
+	}
+
+	int digits = 0;
+	do
+	{
+		*--scanner = '0' + magnitude % 10;
+		magnitude /= 10;
+
+		if (++digits == decimals)
+		{
+			*--scanner = '.';
+		}
+	} while (magnitude > 0 || digits <= decimals);
+
+	if (negative)
+	{
+		*--scanner = '-';
+	}
+
+	out.write(reinterpret_cast<const uint8_t*>(scanner), end - scanner);
+}
+
+/// <summary>
+/// Prints a double with at most precision decimals, dropping trailing zeros.
+/// Uses a single float multiply and printFixed, instead of a float division per digit.
+/// </summary>
+/// <param name="out">The output.</param>
+/// <param name="value">The value.</param>
+/// <param name="precision">The most decimals to print.</param>
+void VirtualShield::printDouble(Print& out, double value, int precision)
+{
+	if (precision > maxPrecision)
+	{
+		precision = maxPrecision;
+	}
+
+	double scaled = value * powersOfTen[precision];
+	if (!(scaled > -2147483647.0 && scaled < 2147483647.0))
+	{
+		// too large to scale (or not a number)
+		out.print(value, precision);
+		return;
+	}
+
+	printFixed(out, static_cast<long>(scaled < 0 ? scaled - 0.5 : scaled + 0.5), precision);
+}
+
+/// <summary>
+/// Prints a Format eptr, replacing each '~' of the flash format string with the next value.
+/// </summary>
+/// <param name="out">The output.</param>
+/// <param name="eptr">The Format eptr.</param>
+void VirtualShield::printFormat(Print& out, EPtr eptr)
+{
+	const char* scanner = eptr.eptrs[0].value;
+	int valueIndex = 0;
+	unsigned char dataChar;
+	while ((dataChar = pgm_read_byte_near(scanner++)) != 0)
+	{
+		if (dataChar == '~' && valueIndex + 1 < eptr.intValue)
+		{
+			printValue(out, eptr.eptrs[++valueIndex]);
+		}
+		else
+		{
+			out.write(dataChar);
+		}
+	}
+}
+
 int VirtualShield::parseToHash(const char* text, unsigned int *hash, int hashCount, char separator, unsigned int length)
 {
 	int index = 0;
@@ -656,7 +2962,7 @@ int VirtualShield::parseToHash(const char* text, unsigned int *hash, int hashCou
 	int hashIndex = 0;
 	int count = 0;
 
-	while ((length == -1 || length-- > 0) && (text[index] || index > start))
+	while ((length == static_cast<unsigned int>(-1) || length-- > 0) && (text[index] || index > start))
 	{
 		if (!text[index] || text[index] == separator || length == 0)
 		{
@@ -676,11 +2982,19 @@ int VirtualShield::parseToHash(const char* text, unsigned int *hash, int hashCou
 }
 
 
+// the compile-time hash must match the values the board computes (16 bits)
+static_assert(static_cast<uint16_t>("REFRESH"_vsh) == 0xC5BF && static_cast<uint16_t>("pressed"_vsh) == 0xDE9E, "constHash differs from hash");
+
 // per Paul Larson - Microsoft Research
 unsigned int VirtualShield::hash(const char* s, unsigned int len, unsigned int seed)
 {
 	unsigned hash = seed;
-	while ((len == -1) ? *s : len-- > 0)
+	if (!s)
+	{
+		return hash;
+	}
+
+	while ((len == static_cast<unsigned int>(-1)) ? *s : len-- > 0)
 	{
 		hash = hash * 101 + *s++;
 	}
@@ -694,49 +3008,76 @@ unsigned int VirtualShield::hash(const char* s, unsigned int len, unsigned int s
 /// <returns>Zero if no error, negative if an error.</returns>
 int VirtualShield::endWrite()
 {
-	if (sendFlashStringOnSerial(MESSAGE_END2) != 0) return SERIAL_ERROR;
+	if (codec != JsonWireCodec)
+	{
+		Cbor::writeBreak(frame);
+	}
+	else if (sendFlashFragment(MESSAGE_END2) != 0) return SERIAL_ERROR;
+
+	if (batchId)
+	{
+		return SERIAL_SUCCESS;
+	}
+
+	frame.capture = 0;
+	sentMessages.end();
+
+	bool sent = frame.end();
 	this->flush();
-	return SERIAL_SUCCESS;
+	return sent ? SERIAL_SUCCESS : SERIAL_ERROR;
 }
 
 int VirtualShield::directToSerial(const char* cmd)
 {
-	_VShieldSerial->print(cmd);
+	frame.print(cmd);
 	return SERIAL_SUCCESS;
 }
 
 /// <summary>
 /// Sends the flash (PROGMEM) string on the communication channel.
+/// The string is walked once; unformatted, unencoded strings are copied as a single block.
 /// </summary>
 /// <param name="flashStringAdr">The flash (PROGMEM) string address.</param>
-/// <returns>Zero if no error, negative if an error.</returns>
+/// <param name="start">The offset to start at. Zero or more stops at the next '~' format position.</param>
+/// <param name="encode">true to escape single quotes.</param>
+/// <returns>Zero if no error, negative if an error, or the position after a '~' when formatted.</returns>
 int VirtualShield::sendFlashStringOnSerial(const char* flashStringAdr, int start, bool encode) const
 {
-	unsigned char dataChar = 0;
-	const int actualStart = start < 0 ? 0 : start;
 	const bool isFormatted = start > DEFAULT_LENGTH;
+	const char* scanner = flashStringAdr + (start < 0 ? 0 : start);
+
+	if (!isFormatted && !encode)
+	{
+		return sendFlashBlock(scanner, strlen_P(scanner));
+	}
 
-	for (int i = actualStart; i < strlen_PF((uint_farptr_t)flashStringAdr); i++)
+	unsigned char dataChar;
+	while ((dataChar = pgm_read_byte_near(scanner++)) != 0)
 	{
-		dataChar = pgm_read_byte_near(flashStringAdr + i);
 		if (isFormatted && dataChar == '~')
 		{
-			return i + 1;
+			return scanner - flashStringAdr;
 		}
 
 		if (encode && dataChar == '\'') 
 		{
-			_VShieldSerial->write('\\');
-#ifdef debugSerial
-			Serial.write('\\');
-#endif
+			frame.write('\\');
 		}
 
-		_VShieldSerial->print((char)dataChar);
-#ifdef debugSerial
-		Serial.print((char)dataChar);
-#endif
+		frame.write(dataChar);
 	}
 
 	return SERIAL_SUCCESS;
 }
+
+/// <summary>
+/// Sends a block of a flash (PROGMEM) string of a known length on the communication channel.
+/// </summary>
+/// <param name="flashStringAdr">The flash (PROGMEM) string address.</param>
+/// <param name="length">The length of the block.</param>
+/// <returns>Zero if no error, negative if an error.</returns>
+int VirtualShield::sendFlashBlock(const char* flashStringAdr, size_t length) const
+{
+	frame.writeFlash(flashStringAdr, length);
+	return SERIAL_SUCCESS;
+}
@@ -41,11 +41,78 @@ struct SensorEvent;
 const long DEFAULT_BAUDRATE = 115200;
 const long WAITFOR_TIMEOUT = 30000;
 
-#define REFRESH_HASH 0xC5BF
-#define CONNECT_HASH 0xA91A
-#define PING_HASH 0x2CFE
-#define SUSPEND_HASH 0xC15E
-#define RESUME_HASH 0x3549
+#define REFRESH_HASH ("REFRESH"_vsh)
+#define CONNECT_HASH ("CONNECT"_vsh)
+#define PING_HASH ("PING"_vsh)
+#define SUSPEND_HASH ("SUSPEND"_vsh)
+#define RESUME_HASH ("RESUME"_vsh)
+#define CODEC_HASH ("CODEC"_vsh)
+#define CHUNK_HASH ("CHUNK"_vsh)
+#define LAST_HASH ("LAST"_vsh)
+#define BATCH_HASH ("BATCH"_vsh)
+
+// Keys and service names replaced by their position (token) once the remote device accepts CborTokenWireCodec.
+// The first 24 entries encode in a single byte. Sent (as 'Dict') only when the remote device asks for tokens.
+// Each file checks that the constants of its keys are entries (see isDictionaryEntry), so the two cannot drift apart.
+#define SHIELD_DICTIONARY \
+	"Service|Id|Action|Message|Tag|TYPE|Y|X|ARGB|Width|Height|Url|Ms|Sensors|Delta|Interval|LCDG|LCDT|SENSORS|Pid|X2|Y2|Parse|Len|" \
+	"Path|To|Attachment|Data|Subject|Cc|UI|CONFIDENCE|IMAGE|Audio|Autoplay|Keep|VALUE|MULTI|" \
+	"WEB|SPEECH|RECOGNIZE|CAMERA|PLAY|MICROPHONE|NOTIFY|VIBRATE|EMAIL|SMS|SYSTEM|BATCH|Batch"
+
+enum WireCodec
+{
+	JsonWireCodec = 0,
+	CborWireCodec = 1,
+	CborTokenWireCodec = 2
+};
+
+/// <summary>
+/// The constant part of a fixed-shape command (see VirtualShield::writeShape), kept in flash: its Action and the keys
+/// of its values, in order. A shape with a list sends its values as the one item of that list, keyed first by the
+/// sensor type ('Sensors':[{'A':1,'Delta':0.1}]), so its first key is not used.
+/// </summary>
+struct Shape
+{
+	const char* action;
+	const char* list;
+	const char* keys[4];
+};
+
+enum RequestState
+{
+	RequestUnknown = 0,
+	RequestPending = 1,
+	RequestCompleted = 2,
+	RequestFailed = 3,
+	RequestTimedOut = 4
+};
+
+// Called when a tracked request completes; shieldEvent is 0 when it timed out.
+typedef void(*RequestCallback)(int id, ShieldEvent* shieldEvent);
+
+/// <summary>
+/// An entry of the output cache (see VirtualShield::setOutputCache), owned by the sketch.
+/// </summary>
+struct OutputCacheEntry
+{
+	unsigned int key;
+	unsigned int payload;
+	int id;
+};
+
+/// <summary>
+/// An entry of the request table (see VirtualShield::setRequestTable), owned by the sketch.
+/// </summary>
+struct PendingRequest
+{
+	int id;
+	int resultId;
+	unsigned long deadline; // once finished: until when the final state is kept for requestState
+	RequestCallback onComplete;
+	RequestState state;
+	unsigned long retryAt;
+	uint8_t resends;
+};
 
 class VirtualShield
 {
@@ -55,17 +122,45 @@ public:
 	void(*onRefresh)(ShieldEvent*) = 0;
 	void(*onSuspend)(ShieldEvent*) = 0;
 	void(*onResume)(ShieldEvent*) = 0;
+	void(*onDrained)(int) = 0;
+	void(*onChunk)(int, const char*, int, bool) = 0;
+
+	int outputCacheHits = 0;
+	int outputCacheMisses = 0;
+	int droppedChunks = 0;
+	int receiveQueueOverflows = 0;
+	int receiveQueuePeak = 0;
+	int framingErrors = 0;
+	int checksumErrors = 0;
+	int rejectedSensors = 0;
+	long keepalivesSent = 0;
+	long keepalivesSaved = 0;
+	int droppedRequests = 0;
+	int retransmits = 0;
+	int requestTimeouts = 0;
+	int duplicatesSuppressed = 0;
 
     VirtualShield();
 
 	void begin(long bitRate = DEFAULT_BAUDRATE);
+	void begin(Stream& stream);
 	void setPort(int port);
+	void enableAsyncSend(bool enable);
 
 	bool checkSensors(int watchForId = 0, long timeout = 0, int waitForResultId = -1);
     int waitFor(int id, long timeout = WAITFOR_TIMEOUT, bool asSuccess = true, int resultId = -1);
+	int waitForAll(const int ids[], int count, long timeout = WAITFOR_TIMEOUT);
+	int waitForAny(const int ids[], int count, long timeout = WAITFOR_TIMEOUT);
+	void setRequestTable(PendingRequest* requests, int count);
+	int track(int id, RequestCallback onComplete = 0, long timeout = WAITFOR_TIMEOUT, int resultId = -1);
+	RequestState requestState(int id);
+	void untrack(int id);
+	void setRetransmitBuffer(char* buffer, int size, int retries = 2, long retryTimeout = 1000);
 	bool hasError(ShieldEvent* shieldEvent = 0);
 
 	bool getEvent(ShieldEvent* shieldEvent);
+	int poll();
+	void setReceiveQueue(char* buffer, int size);
 
 	int directToSerial(const char* cmd);
 
@@ -77,6 +172,55 @@ public:
 	int writeAll(const char* serviceName, EPtr values[], int count, Attr extraAttributes[] = 0, int extraAttributeCount = 0, const char sensorType = '\0');
 
 	int writeAll(const char* serviceName);
+	/// <summary>
+	/// Writes a fixed-shape command: only the values are formatted at runtime, one for each key of the flash shape.
+	/// The sensor type (if any) is sent as TYPE, or keys the list item of a list shape; the options follow as EPtrs.
+	/// Returns zero when the command has to be written from EPtrs instead (binary encodings).
+	/// </summary>
+	template <typename... Values>
+	int writeShape(const char* serviceName, const Shape* shape, char sensorType, EPtr options[], int optionCount, Values... values)
+	{
+		if (!canWriteShape())
+		{
+			return 0;
+		}
+
+		int id = beginShape(serviceName, shape);
+		writeShapeValues(shapeOutput(), shape, 0, sensorType, values...);
+		return endShape(shape, sensorType, options, optionCount) == 0 ? id : -1;
+	}
+
+	/// <summary>
+	/// Writes a fixed-shape command like writeShape(), unless it matches the last message written for the cache key
+	/// (only when the output cache is enabled, see writeCached()).
+	/// </summary>
+	template <typename... Values>
+	int writeCachedShape(unsigned int cacheKey, const char* serviceName, const Shape* shape, char sensorType, EPtr options[], int optionCount, Values... values)
+	{
+		if (!allowOutputCache || !canWriteShape())
+		{
+			return writeShape(serviceName, shape, sensorType, options, optionCount, values...);
+		}
+
+		PayloadHash payload(hashPayload(options, optionCount, reinterpret_cast<uintptr_t>(shape) * 101 + sensorType));
+		writeShapeValues(payload, 0, 0, 0, values...);
+
+		int id = findCached(cacheKey, payload.value);
+		if (id == 0)
+		{
+			id = writeShape(serviceName, shape, sensorType, options, optionCount, values...);
+			rememberCached(cacheKey, payload.value, id);
+		}
+
+		return id;
+	}
+
+	bool canWriteShape() const
+	{
+		return codec == JsonWireCodec;
+	}
+
+	int writeCached(unsigned int cacheKey, const char* serviceName, EPtr values[], int count, Attr extraAttributes[] = 0, int extraAttributeCount = 0, const char sensorType = '\0');
 
 	int beginWrite(const char* serviceName) ;
 	int write(EPtr eptr) const;
@@ -85,6 +229,9 @@ public:
 
     int block(int id, bool blocking, long timeout = WAITFOR_TIMEOUT, int waitForResultId = -1);
 
+	int beginBatch();
+	int commitBatch(bool blocking = false);
+
 	void setOnEvent(void(*onEvent)(ShieldEvent*))
 	{
 		this->onEvent = onEvent;
@@ -110,6 +257,26 @@ public:
 		this->onResume = onResume;
 	}
 
+	/// <summary>
+	/// Sets the callback for when a queued message has been fully handed to the stream (async send only).
+	/// The callback receives the id of the last drained message.
+	/// </summary>
+	void setOnDrained(void(*onDrained)(int))
+	{
+		this->onDrained = onDrained;
+	}
+
+	/// <summary>
+	/// Sets the callback receiving each fragment of a large (chunked) message as it arrives: id, data, length and
+	/// whether it is the last fragment. Set before begin(), so the remote device is told it may send chunks.
+	/// </summary>
+	void setOnChunk(void(*onChunk)(int, const char*, int, bool))
+	{
+		this->onChunk = onChunk;
+	}
+
+	void setChunkBuffer(char* buffer, int size);
+
 	/// <summary>
 	/// Enables or disables block() to block for specific id-based responses.
 	/// </summary>
@@ -117,26 +284,172 @@ public:
 		this->allowAutoBlocking = enable; 
 	}
 
+	void setOutputCache(OutputCacheEntry* entries, int count);
+	void clearOutputCache();
+	static unsigned int cacheKey(const char* serviceName, unsigned int x, unsigned int y, const char* tag = 0);
+
+	// the number formatting used for messages, also usable on any Print (i.e. Serial)
+	static void printFixed(Print& out, long value, int decimals);
+	static void printDouble(Print& out, double value, int precision);
+
+	/// <summary>
+	/// Enables or disables offering the compact binary (CBOR) encoding to the remote device. JSON is always the fallback.
+	/// </summary>
+	void enableBinaryProtocol(bool enable) {
+		this->allowBinary = enable;
+		if (!enable) {
+			this->codec = JsonWireCodec;
+		}
+	}
+
+	/// <summary>
+	/// Enables or disables offering checksums (CRC-8) to the remote device. Once it sends a checksummed message,
+	/// messages that fail or lack the checksum are dropped and counted in checksumErrors. Set before begin().
+	/// </summary>
+	void enableChecksum(bool enable) {
+		this->allowChecksum = enable;
+	}
+
+	void setKeepalive(long minInterval, long maxInterval, long pendingInterval);
+
 	int parseToHash(const char* text, unsigned int *hash, int hashCount, char separator = ' ', unsigned int length = -1);
 	static unsigned int hash(const char* s, unsigned int len = -1, unsigned int seed = 0);
 
+	/// <summary>
+	/// Computes hash() at compile time when given a literal (see the _vsh literal).
+	/// </summary>
+	static constexpr unsigned int constHash(const char* s, unsigned int seed = 0) {
+		return *s ? constHash(s + 1, seed * 101 + *s) : seed;
+	}
+
+	/// <summary>
+	/// Whether a (constexpr) key is an entry of SHIELD_DICTIONARY, for static_assert.
+	/// </summary>
+	static constexpr bool isDictionaryEntry(const char* key, const char* entry = SHIELD_DICTIONARY) {
+		return *entry && (isDictionaryEntryAt(key, entry) || isDictionaryEntry(key, nextDictionaryEntry(entry)));
+	}
+
 protected:
 	int sendFlashStringOnSerial(const char* flashStringAdr, int start = -1, bool encode = false) const;
+	int sendFlashBlock(const char* flashStringAdr, size_t length) const;
+
+	/// <summary>
+	/// Sends a constant flash (PROGMEM) fragment whose length is known at compile time.
+	/// </summary>
+	template <size_t N>
+	int sendFlashFragment(const char (&fragment)[N]) const
+	{
+		return sendFlashBlock(fragment, N - 1);
+	}
 
 	void onJsonStringReceived(char* json, ShieldEvent* shieldEvent);
 	void onStringReceived(char* buffer, int length, ShieldEvent* shieldEvent);
+	void onBinaryReceived(char* buffer, int length, ShieldEvent* shieldEvent);
+	void onTokensReceived(char* tokens, int length, ShieldEvent* shieldEvent);
+	void onChunkReceived(JsonObject& root, ShieldEvent* shieldEvent);
 
 	void flush();
 
     Stream* _VShieldSerial;
 private:
+	int port = 1;
 	int nextId = 1;
 	ShieldEvent recentEvent;
 	bool allowAutoBlocking = true;
-
+	bool allowBinary = true;
+	bool allowOutputCache = false;
+	bool allowChecksum = false;
+	long minKeepaliveInterval = 1000;
+	long maxKeepaliveInterval = 16000;
+	long pendingKeepaliveInterval = 250;
+	int maxRetries = 0;
+	long retryTimeout = 1000;
+	WireCodec codec = JsonWireCodec;
+
+	static Sensor** findSensors(char sensorType);
 	void sendPingBack(ShieldEvent* shieldEvent);
     void sendStart();
+	void sendDictionary();
+	void useCodec(WireCodec accepted);
+	void writeUrgent(EPtr values[], int count);
+	void completeRequests(ShieldEvent* shieldEvent);
+	void expireRequests();
+	void pumpWrites();
+
+	/// <summary>
+	/// A Print that only keeps a hash of what is printed, used to compare payloads without sending them.
+	/// </summary>
+	class PayloadHash : public Print
+	{
+	public:
+		unsigned int value;
+
+		PayloadHash(unsigned int seed) : value(seed) {}
+
+		size_t write(uint8_t c) override
+		{
+			value = value * 101 + c;
+			return 1;
+		}
+
+		using Print::write;
+	};
+
+	int findCached(unsigned int cacheKey, unsigned int payload);
+	void rememberCached(unsigned int cacheKey, unsigned int payload, int id);
+
+	static Print& shapeOutput();
+	int beginShape(const char* serviceName, const Shape* shape);
+	int endShape(const Shape* shape, char sensorType, EPtr options[], int optionCount);
+	void writeShapeKey(const Shape* shape, int index, char sensorType) const;
+
+	void writeShapeValues(Print&, const Shape*, int, char) const {}
+
+	/// <summary>
+	/// Writes each value after its key from the shape; without a shape, only the values (to hash them).
+	/// </summary>
+	template <typename Value, typename... Values>
+	void writeShapeValues(Print& out, const Shape* shape, int index, char sensorType, Value value, Values... values) const
+	{
+		if (shape)
+		{
+			writeShapeKey(shape, index, sensorType);
+		}
+
+		printShapeValue(out, value);
+		writeShapeValues(out, shape, index + 1, sensorType, values...);
+	}
+
+	static void printShapeValue(Print& out, unsigned int value);
+	static void printShapeValue(Print& out, int value);
+	static void printShapeValue(Print& out, long value);
+	static void printShapeValue(Print& out, double value);
+	static void printShapeValue(Print& out, const char* text);
+
 	int writeValue(EPtr eptr, int start = 0) const;
+	int writeCborValue(EPtr eptr) const;
+	void writeCborKey(const char* flashKey) const;
+
+	static int findToken(const char* flashKey);
+
+	static constexpr bool isDictionaryEntryAt(const char* key, const char* entry) {
+		return *entry == '|' || *entry == 0 ? *key == 0 : *entry == *key && isDictionaryEntryAt(key + 1, entry + 1);
+	}
+
+	static constexpr const char* nextDictionaryEntry(const char* entry) {
+		return *entry == 0 ? entry : *entry == '|' ? entry + 1 : nextDictionaryEntry(entry + 1);
+	}
+
+	static unsigned int hashPayload(EPtr values[], int count, unsigned int seed);
+	static void printValue(Print& out, EPtr eptr);
+	static void printFormat(Print& out, EPtr eptr);
 };
 
+/// <summary>
+/// The hash (VirtualShield::hash) of a literal, computed by the compiler: case "pressed"_vsh:
+/// </summary>
+constexpr unsigned int operator"" _vsh(const char* s, size_t /*length*/) {
+	return VirtualShield::constHash(s);
+}
+
 #endif 
\ No newline at end of file
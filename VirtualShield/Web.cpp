@@ -31,12 +31,15 @@ extern "C" {
 #include <stdlib.h>
 }
 
-const PROGMEM char SERVICE_WEB[] = "WEB";
+constexpr PROGMEM char SERVICE_WEB[] = "WEB";
 const PROGMEM char GET[] = "Get";
 const PROGMEM char POST[] = "Post";
-const PROGMEM char DATA[] = "Data";
+constexpr PROGMEM char DATA[] = "Data";
 
-const PROGMEM char LEN[] = "Len";
+constexpr PROGMEM char LEN[] = "Len";
+
+static_assert(VirtualShield::isDictionaryEntry(SERVICE_WEB) && VirtualShield::isDictionaryEntry(DATA) &&
+	VirtualShield::isDictionaryEntry(LEN) && VirtualShield::isDictionaryEntry(PARSE), "a Web key is not in SHIELD_DICTIONARY");
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Web"/> class.
@@ -27,7 +27,7 @@
 
 #include "Sensor.h"
 
-const PROGMEM char PARSE[] = "Parse";
+constexpr PROGMEM char PARSE[] = "Parse";
 
 namespace ArduinoJson{
 	class JsonObject;
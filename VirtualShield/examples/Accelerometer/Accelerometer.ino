@@ -32,6 +32,8 @@ VirtualShield shield;			                    // identify the shield
 Graphics screen = Graphics(shield);		            // connect a screen to the shield
 Accelerometer accelermeter = Accelerometer(shield);         // connect an accelerometer to the shield
 
+OutputCacheEntry outputCache[4];                            // the last X, Y and Z lines sent
+
 int startFastButtonId, stopButtonId, startTimedButtonId, startDeltaButtonId; // ids for start and stop buttons
 
 // function to handle accelerometer events
@@ -84,6 +86,9 @@ void setup()
     shield.setOnRefresh(refresh);
     accelermeter.setOnEvent(accelermeterEvent);
 
+    // Skip sending lines that have not changed
+    shield.setOutputCache(outputCache, 4);
+
     shield.begin(); // begin communication (automatically calls refresh event)
 }
 
@@ -63,6 +63,8 @@ void screenEvent(ShieldEvent* event)
 // Refresh event callback
 void refresh(ShieldEvent* event)
 {
+	// Send the whole screen as one batch (one message at a time if the app does not support batches)
+	shield.beginBatch();
 	screen.clear();
 
 	digitalWrite(redPin, LOW);
@@ -76,6 +78,7 @@ void refresh(ShieldEvent* event)
 
         // Listen for 
 	speech.listenFor("green,yellow,red,off", false);
+	shield.commitBatch();
 }
 
 void speechEvent(ShieldEvent* event)
@@ -49,28 +49,28 @@ const PROGMEM char RECOGNITIONTEXT[] =
 
 enum
 {
-	Sunny = 2049,
-	Clear = 49059,
-
-	Cloudy = 59736,
-
-	Chance = 24982,
-	Chc = 38710,
-	Likely = 45926,
-	Mostly = 14784,
-	Partly = 1588,
-	Heavy = 18937,
-	Strong = 22737,
-	Moderate = 22245,
-
-	Showers = 2743,
-	Rain = 25950,
-	Thunderstorms = 10146,
-
-	Tonight = 20685,
-	Overnight = 56786,
-	Strike = 26762,
-	Lightning = 37184
+	Sunny = "Sunny"_vsh,
+	Clear = "Clear"_vsh,
+
+	Cloudy = "Cloudy"_vsh,
+
+	Chance = "Chance"_vsh,
+	Chc = "Chc"_vsh,
+	Likely = "Likely"_vsh,
+	Mostly = "Mostly"_vsh,
+	Partly = "Partly"_vsh,
+	Heavy = "Heavy"_vsh,
+	Strong = "Strong"_vsh,
+	Moderate = "Moderate"_vsh,
+
+	Showers = "Showers"_vsh,
+	Rain = "Rain"_vsh,
+	Thunderstorms = "Thunderstorms"_vsh,
+
+	Tonight = "Tonight"_vsh,
+	Overnight = "Overnight"_vsh,
+	Strike = "Strike"_vsh,
+	Lightning = "Lightning"_vsh
 };
 
 static const unsigned int idToHash[8][2] = { { Thunderstorms, 0 }, { Rain, 0 }, { Mostly, Cloudy }, { Sunny, 0 }, { Clear, 0 }, { Partly, Cloudy }, { Showers, 0 }, {Strike, 0} };
@@ -0,0 +1,123 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+
+#include <ArduinoJson.h>
+
+#include <VirtualShield.h>
+#include <Protothread.h>
+#include <Text.h>
+#include <Speech.h>
+#include <Recognition.h>
+
+VirtualShield shield;	          // identify the shield
+Text screen = Text(shield);	  // connect the screen
+Speech speech = Speech(shield);	  // connect text to speech
+Recognition recognition = Recognition(shield);	  // connect speech to text
+
+int LED_PIN = 13;
+
+Protothread blinker, listener, uptime;
+PendingRequest requests[2];	  // one awaited request for each of listener and uptime
+bool isBlinking = true;
+
+// blinks the LED while 'on'
+ProtothreadState blink(Protothread* pt)
+{
+	PT_BEGIN(pt);
+	while (true)
+	{
+		PT_WAIT_UNTIL(pt, isBlinking);
+		digitalWrite(LED_PIN, HIGH);
+		PT_DELAY(pt, 250);
+		digitalWrite(LED_PIN, LOW);
+		PT_DELAY(pt, 250);
+	}
+	PT_END(pt);
+}
+
+// listens for 'on' or 'off', giving up after 10 seconds of silence
+ProtothreadState listen(Protothread* pt)
+{
+	PT_BEGIN(pt);
+	while (true)
+	{
+		recognition.listenFor("on,off", false);
+		PT_AWAIT_UPDATE_TIMEOUT(pt, recognition, 10000);
+
+		if (pt->isTimedOut)
+		{
+			screen.printAt(4, "Still listening...");
+		}
+		else if (recognition.recognizedIndex > 0)
+		{
+			isBlinking = recognition.recognizedIndex == 1;
+			PT_AWAIT_REQUEST(pt, shield, speech.speak(isBlinking ? "Blinking" : "Stopped"), 5000);
+		}
+	}
+	PT_END(pt);
+}
+
+// shows the uptime every second, waiting for each line to be shown
+ProtothreadState tick(Protothread* pt)
+{
+	PT_BEGIN(pt);
+	while (true)
+	{
+		PT_AWAIT_REQUEST(pt, shield, screen.printAt(2, "Up " + String(millis() / 1000) + "s"), 2000);
+		PT_DELAY(pt, 1000);
+	}
+	PT_END(pt);
+}
+
+// when Bluetooth connects, or the 'Refresh' button is pressed
+void refresh(ShieldEvent* event)
+{
+	screen.clear();
+	screen.printAt(1, "Say 'on' or 'off'");
+
+	listener.restart();
+	uptime.restart();
+}
+
+void setup()
+{
+	pinMode(LED_PIN, OUTPUT);
+
+	shield.enableAutoBlocking(false);	// requests return their id at once; the flows await them
+	shield.setRequestTable(requests, 2);
+	shield.setOnRefresh(refresh);
+
+	// begin() communication - you may specify a baud rate here, default is 115200
+	shield.begin();
+}
+
+void loop()
+{
+	shield.checkSensors();		    // handles Virtual Shield events.
+
+	blink(&blinker);
+	listen(&listener);
+	tick(&uptime);
+}
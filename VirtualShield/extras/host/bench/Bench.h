@@ -0,0 +1,206 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// The benchmark harness of the host build. Bench::run times a call over many iterations and reports per call:
+// wall time, retired instructions (when the kernel allows perf counters), stack depth, bytes written to the
+// recording stream and heap allocations. Host numbers are not AVR cycles, but they move with them.
+
+#ifndef Bench_h
+#define Bench_h
+
+#include "Arduino.h"
+#include "Host.h"
+#include "MockStream.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <alloca.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+struct BenchResult
+{
+	const char* name;
+	long iterations;
+	double nanosPerCall;
+	double instructionsPerCall;
+	size_t stackBytes;
+	double bytesPerCall;
+	double allocationsPerCall;
+};
+
+class Bench
+{
+public:
+	/// <summary>
+	/// Runs a call for a number of iterations and prints its per-call costs. The stream is cleared every iteration;
+	/// the bytes written to it are counted.
+	/// </summary>
+	template <typename Call>
+	static BenchResult run(const char* name, MockStream& stream, long iterations, Call call)
+	{
+		BenchResult result = { name, iterations, 0, -1, 0, 0, 0 };
+
+		// the first call resolves library symbols and grows the recording buffers,
+		// which takes stack the call itself does not
+		call();
+		clearOutput(stream);
+		result.stackBytes = stackUsed(call);
+		clearOutput(stream);
+
+		unsigned long long bytes = 0;
+		Host::resetAllocations();
+		int counter = openInstructionCounter();
+		long long instructionsBefore = readCounter(counter);
+		unsigned long long started = nanos();
+
+		for (long i = 0; i < iterations; i++)
+		{
+			call();
+			bytes += stream.output.size();
+			clearOutput(stream);
+		}
+
+		unsigned long long elapsed = nanos() - started;
+		long long instructionsAfter = readCounter(counter);
+		if (counter >= 0)
+		{
+			close(counter);
+			result.instructionsPerCall = static_cast<double>(instructionsAfter - instructionsBefore) / iterations;
+		}
+
+		result.nanosPerCall = static_cast<double>(elapsed) / iterations;
+		result.bytesPerCall = static_cast<double>(bytes) / iterations;
+		result.allocationsPerCall = Host::countsAllocations() ? static_cast<double>(Host::allocations()) / iterations : -1;
+		print(result);
+		return result;
+	}
+
+	static void header(const char* title)
+	{
+		printf("\n%s\n", title);
+		printf("%-36s %12s %12s %10s %10s %10s\n", "call", "ns/call", "instr/call", "stack B", "bytes", "allocs");
+	}
+
+	static void print(const BenchResult& result)
+	{
+		char instructions[24];
+		char allocations[24];
+		snprintf(instructions, sizeof(instructions), result.instructionsPerCall < 0 ? "-" : "%.0f", result.instructionsPerCall);
+		snprintf(allocations, sizeof(allocations), result.allocationsPerCall < 0 ? "-" : "%.2f", result.allocationsPerCall);
+		printf("%-36s %12.1f %12s %10zu %10.1f %10s\n", result.name, result.nanosPerCall, instructions,
+			result.stackBytes, result.bytesPerCall, allocations);
+	}
+
+	/// <summary>
+	/// Measures how deep a call goes into the stack: the region below the caller is painted, the call is made,
+	/// and the painted bytes left untouched are counted.
+	/// </summary>
+	template <typename Call>
+	static size_t stackUsed(Call& call)
+	{
+		paintStack();
+		call();
+		return paintedStackUsed();
+	}
+
+private:
+	static void clearOutput(MockStream& stream)
+	{
+		// keeps the capacity, so recording does not allocate while measuring
+		stream.output.clear();
+		stream.writes.clear();
+	}
+
+	static const size_t stackPaintSize = 64 * 1024;
+	static const unsigned char stackPaint = 0xA5;
+
+	static char*& paintedStack()
+	{
+		static char* area = 0;
+		return area;
+	}
+
+	__attribute__((noinline)) static void paintStack()
+	{
+		char* area = static_cast<char*>(alloca(stackPaintSize));
+		memset(area, stackPaint, stackPaintSize);
+		__asm__ __volatile__("" : : "r"(area) : "memory");
+		paintedStack() = area;
+	}
+
+	__attribute__((noinline)) static size_t paintedStackUsed()
+	{
+		const char* area = paintedStack();
+		size_t untouched = 0;
+		while (untouched < stackPaintSize && static_cast<unsigned char>(area[untouched]) == stackPaint)
+		{
+			untouched++;
+		}
+
+		return stackPaintSize - untouched;
+	}
+
+	static unsigned long long nanos()
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return now.tv_sec * 1000000000ULL + now.tv_nsec;
+	}
+
+	static int openInstructionCounter()
+	{
+		struct perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.size = sizeof(attributes);
+		attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		int counter = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+		if (counter >= 0)
+		{
+			ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+			ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+		}
+
+		return counter;
+	}
+
+	static long long readCounter(int counter)
+	{
+		long long value = 0;
+		if (counter < 0 || read(counter, &value, sizeof(value)) != sizeof(value))
+		{
+			return 0;
+		}
+
+		return value;
+	}
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Bytes and time per command with each wire encoding: JSON, CBOR and CBOR with dictionary tokens.
+// The encoding is switched the way the remote device does it, with a CODEC system message.
+
+#include "Bench.h"
+
+#include "VirtualShield.h"
+#include "Cbor.h"
+#include "Text.h"
+#include "Graphics.h"
+#include "Accelerometer.h"
+#include "Web.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static Accelerometer accelerometer(shield);
+static Web web(shield);
+
+static const char* const codecNames[] = { "JSON", "CBOR", "CBOR+tokens" };
+
+static void useCodec(int codec)
+{
+	char reply[64];
+	snprintf(reply, sizeof(reply), "{'Type':'!','Result':'CODEC','Value':%d}", codec);
+	stream.receive(reply);
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+}
+
+static void readAll()
+{
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+}
+
+int main()
+{
+	const long iterations = 20000;
+
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+
+	for (int codec = JsonWireCodec; codec <= CborTokenWireCodec; codec++)
+	{
+		useCodec(codec);
+		char title[48];
+		snprintf(title, sizeof(title), "encode (%s)", codecNames[codec]);
+		Bench::header(title);
+		Bench::run("Text::printAt(line, String)", stream, iterations, [] { screen.printAt(2, "Hello World"); });
+		Bench::run("Text::printAt(line, double)", stream, iterations, [] { screen.printAt(3, 21.5625); });
+		Bench::run("Graphics::fillRectangle", stream, iterations, [] { screen.fillRectangle(120, 80, 70, 70, ARGB(255, 0, 0), "red"); });
+		Bench::run("Graphics::line", stream, iterations, [] { screen.line(0, 0, 240, 320, ARGB(0, 0, 255), 2); });
+		Bench::run("Sensor::start", stream, iterations, [] { accelerometer.start(0.2, 1000); });
+		Bench::run("Web::get", stream, iterations, [] { web.get("http://example.com/weather", "J:main.temp"); });
+	}
+
+	useCodec(JsonWireCodec);
+
+	// the same accelerometer event as the remote device sends it in each encoding
+	static const char json[] = "{'Type':'A','Id':5,'X':0.5,'Y':-1,'Z':2}";
+	static std::string binary;
+	MockStream encoder;
+	Cbor::writeIndefinite(encoder, CBOR_MAP);
+	Cbor::writeText(encoder, "Type", 4);
+	Cbor::writeText(encoder, "A", 1);
+	Cbor::writeText(encoder, "Id", 2);
+	Cbor::writeInt(encoder, 5);
+	Cbor::writeText(encoder, "X", 1);
+	Cbor::writeFloat(encoder, 0.5);
+	Cbor::writeText(encoder, "Y", 1);
+	Cbor::writeInt(encoder, -1);
+	Cbor::writeText(encoder, "Z", 1);
+	Cbor::writeInt(encoder, 2);
+	Cbor::writeBreak(encoder);
+	binary += static_cast<char>(BINARY_FRAME_START);
+	binary += static_cast<char>(encoder.output.size());
+	binary += encoder.output;
+
+	printf("\ndecode: accelerometer event of %zu bytes (JSON) and %zu bytes (CBOR)\n", strlen(json), binary.size());
+	Bench::header("decode");
+	Bench::run("getEvent (JSON)", stream, iterations, [] { stream.receive(json); readAll(); });
+	Bench::run("getEvent (CBOR)", stream, iterations, [] { stream.receive(binary.data(), binary.size()); readAll(); });
+
+	return 0;
+}
@@ -0,0 +1,75 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Dispatch costs per inbound message type: reading the message from the stream, parsing it and filling the event and
+// the sensor (through its field schema or its own onJsonReceived).
+
+#include "Bench.h"
+
+#include "VirtualShield.h"
+#include "Graphics.h"
+#include "Accelerometer.h"
+#include "Geolocator.h"
+#include "Compass.h"
+#include "LightSensor.h"
+#include "Web.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static Accelerometer accelerometer(shield);
+static Geolocator geolocator(shield);
+static Compass compass(shield);
+static LightSensor lightSensor(shield);
+static Web web(shield);
+
+static void dispatch(const char* message)
+{
+	stream.receive(message);
+
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+}
+
+int main()
+{
+	const long iterations = 20000;
+
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+
+	Bench::header("dispatch per message type");
+	Bench::run("accelerometer (3 fields)", stream, iterations, [] { dispatch("{'Type':'A','Id':5,'X':0.5,'Y':-1,'Z':2}"); });
+	Bench::run("geolocator (3 fields)", stream, iterations, [] { dispatch("{'Type':'L','Id':6,'Lat':47.6097,'Lon':-122.3331,'Alt':56}"); });
+	Bench::run("compass (1 field)", stream, iterations, [] { dispatch("{'Type':'M','Id':7,'Mag':271.5}"); });
+	Bench::run("light sensor (1 field)", stream, iterations, [] { dispatch("{'Type':'P','Id':8,'Lux':320}"); });
+	Bench::run("screen event", stream, iterations, [] { dispatch("{'Type':'S','Id':9,'Tag':'go','Action':'pressed','X':10,'Y':20}"); });
+	Bench::run("web response", stream, iterations, [] { dispatch("{'Type':'W','Id':10,'ResultId':4,'Result':'200','Value':'21.5'}"); });
+	Bench::run("unknown type", stream, iterations, [] { dispatch("{'Type':'K','Id':11,'Value':1}"); });
+	Bench::run("system PING (writes PONG)", stream, iterations, [] { dispatch("{'Type':'!','Result':'PING'}"); });
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Number formatting: the library's integer formatter (printFixed/printDouble) against Print::print, which the values
+// went through before. The first rows print a bare value, the others a whole printAt message.
+
+#include "Bench.h"
+
+#include "VirtualShield.h"
+#include "Text.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Text screen(shield);
+
+int main()
+{
+	const long iterations = 20000;
+
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+
+	Bench::header("bare values");
+	Bench::run("Print::print(21.5625, 4)", stream, iterations, [] { stream.print(21.5625, 4); });
+	Bench::run("Print::print(1.0, 4)", stream, iterations, [] { stream.print(1.0, 4); });
+	Bench::run("Print::print(-12345.678, 4)", stream, iterations, [] { stream.print(-12345.678, 4); });
+	Bench::run("Print::print(long)", stream, iterations, [] { stream.print(-1234567L); });
+	Bench::run("printDouble(21.5625, 4)", stream, iterations, [] { VirtualShield::printDouble(stream, 21.5625, 4); });
+	Bench::run("printDouble(1.0, 4)", stream, iterations, [] { VirtualShield::printDouble(stream, 1.0, 4); });
+	Bench::run("printDouble(-12345.678, 4)", stream, iterations, [] { VirtualShield::printDouble(stream, -12345.678, 4); });
+	Bench::run("printFixed(long)", stream, iterations, [] { VirtualShield::printFixed(stream, -1234567L, 0); });
+	Bench::run("printFixed(21562, 3)", stream, iterations, [] { VirtualShield::printFixed(stream, 21562L, 3); });
+
+	Bench::header("printAt messages");
+	Bench::run("Double 21.5625", stream, iterations, [] { screen.printAt(1, EPtr(MESSAGE, 21.5625)); });
+	Bench::run("Double 1.0", stream, iterations, [] { screen.printAt(1, EPtr(MESSAGE, 1.0)); });
+	Bench::run("Double -12345.678", stream, iterations, [] { screen.printAt(1, EPtr(MESSAGE, -12345.678)); });
+	Bench::run("Double 21.5625, precision 2", stream, iterations, [] { screen.printAt(1, EPtr(MESSAGE, 21.5625, 2)); });
+	Bench::run("Fixed 21562 milli-units", stream, iterations, [] { screen.printAt(1, EPtr(MESSAGE, 21562L, Fixed, 3)); });
+	Bench::run("Long -1234567", stream, iterations, [] { screen.printAt(1, EPtr(MESSAGE, -1234567L)); });
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Costs per public call: each command is written to a recording stream (nothing is sent back, so no call blocks).
+
+#include "Bench.h"
+
+#include "VirtualShield.h"
+#include "Text.h"
+#include "Graphics.h"
+#include "Accelerometer.h"
+#include "Web.h"
+#include "Speech.h"
+#include "Notification.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static Accelerometer accelerometer(shield);
+static Web web(shield);
+static Speech speech(shield);
+static Notification notification(shield);
+
+int main()
+{
+	const long iterations = 20000;
+
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+
+	Bench::header("public calls");
+	Bench::run("Text::printAt(line, String)", stream, iterations, [] { screen.printAt(2, "Hello World"); });
+	Bench::run("Text::printAt(line, double)", stream, iterations, [] { screen.printAt(3, 21.5625); });
+	Bench::run("Text::print(String)", stream, iterations, [] { screen.print("Hello World"); });
+	Bench::run("Graphics::fillRectangle", stream, iterations, [] { screen.fillRectangle(120, 80, 70, 70, ARGB(255, 0, 0), "red"); });
+	Bench::run("Graphics::line", stream, iterations, [] { screen.line(0, 0, 240, 320, ARGB(0, 0, 255), 2); });
+	Bench::run("Graphics::addButton", stream, iterations, [] { screen.addButton(10, 300, "Press", "go"); });
+	Bench::run("Sensor::start", stream, iterations, [] { accelerometer.start(0.2, 1000); });
+	Bench::run("Web::get", stream, iterations, [] { web.get("http://example.com/weather", "J:main.temp"); });
+	Bench::run("Speech::speak", stream, iterations, [] { speech.speak("Hello"); });
+	Bench::run("Notification::toast", stream, iterations, [] { notification.toast("Done"); });
+
+	Bench::header("inbound events");
+	Bench::run("getEvent (accelerometer)", stream, iterations, [] {
+		stream.receive("{'Type':'A','Id':5,'X':0.5,'Y':-1,'Z':2}");
+		ShieldEvent event;
+		while (shield.getEvent(&event))
+		{
+		}
+	});
+
+	return 0;
+}
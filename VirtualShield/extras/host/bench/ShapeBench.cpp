@@ -0,0 +1,112 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Fixed-shape commands against the EPtr form of the same messages, written through writeAll() as they were before
+// shapes. The difference is what a shape saves per call.
+
+#include "Bench.h"
+
+#include "VirtualShield.h"
+#include "Graphics.h"
+#include "Accelerometer.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static Accelerometer accelerometer(shield);
+
+const PROGMEM char GRAPHICS[] = "LCDG";
+const PROGMEM char TEXT[] = "LCDT";
+const PROGMEM char SENSORS_SERVICE[] = "SENSORS";
+const PROGMEM char LINE[] = "LINE";
+const PROGMEM char RECTANGLE[] = "RECTANGLE";
+const PROGMEM char X[] = "X";
+const PROGMEM char X2[] = "X2";
+const PROGMEM char Y2[] = "Y2";
+const PROGMEM char WIDTH[] = "Width";
+const PROGMEM char HEIGHT[] = "Height";
+const PROGMEM char SENSORS[] = "Sensors";
+const PROGMEM char DELTA[] = "Delta";
+const PROGMEM char INTERVAL[] = "Interval";
+
+static int lineFromEPtrs()
+{
+	EPtr eptrs[] = { EPtr(ACTION, LINE), EPtr(Y, (uint32_t)0), EPtr(X, (uint32_t)0),
+		EPtr(X2, (uint32_t)240), EPtr(Y2, (uint32_t)320), EPtr(RGBAKEY, (uint32_t)0xff0000ff, Uint), EPtr(WIDTH, (uint32_t)2, Uint) };
+	return shield.writeAll(GRAPHICS, eptrs, 7, 0, 0, 'S');
+}
+
+static int rectangleFromEPtrs()
+{
+	EPtr eptrs[] = { EPtr(ACTION, RECTANGLE), EPtr(Y, (uint32_t)80), EPtr(X, (uint32_t)120),
+		EPtr(WIDTH, (uint32_t)70), EPtr(HEIGHT, (uint32_t)70), EPtr(RGBAKEY, (uint32_t)0xffff0000, Uint),
+		EPtr(MemPtr, TAG, "red") };
+	return shield.writeAll(GRAPHICS, eptrs, 7, 0, 0, 'S');
+}
+
+static int printAtFromEPtrs(const String& text)
+{
+	EPtr eptrs[] = { EPtr(Y, (uint32_t)2), EPtr(MemPtr, MESSAGE, text.c_str()) };
+	return shield.writeAll(TEXT, eptrs, 2, 0, 0, 'S');
+}
+
+static int printNumberFromEPtrs()
+{
+	EPtr eptrs[] = { EPtr(Y, (uint32_t)3), EPtr(MESSAGE, 21.5625), EPtr(RGBAKEY, (uint32_t)0, None) };
+	return shield.writeAll(TEXT, eptrs, 3, 0, 0, 'S');
+}
+
+static int sensorStartFromEPtrs()
+{
+	const char sensorType[2] = { 'A', 0 };
+	EPtr type = EPtr(sensorType, 2);
+	type.keyIsMem = true;
+
+	EPtr eptrs[] = { EPtr(ArrayStart, SENSORS), type, EPtr(DELTA, 0.2), EPtr(INTERVAL, 1000L), EPtr(ArrayEnd) };
+	return shield.writeAll(SENSORS_SERVICE, eptrs, 5);
+}
+
+int main()
+{
+	const long iterations = 20000;
+
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+
+	Bench::header("fixed shapes");
+	Bench::run("Graphics::line", stream, iterations, [] { screen.line(0, 0, 240, 320, ARGB(0xff0000ff), 2); });
+	Bench::run("Graphics::fillRectangle", stream, iterations, [] { screen.fillRectangle(120, 80, 70, 70, ARGB(0xffff0000), "red"); });
+	Bench::run("Text::printAt(line, String)", stream, iterations, [] { screen.printAt(2, "Hello World"); });
+	Bench::run("Text::printAt(line, double)", stream, iterations, [] { screen.printAt(3, 21.5625); });
+	Bench::run("Sensor::start", stream, iterations, [] { accelerometer.start(0.2, 1000); });
+
+	Bench::header("EPtr forms");
+	Bench::run("line", stream, iterations, [] { lineFromEPtrs(); });
+	Bench::run("fillRectangle", stream, iterations, [] { rectangleFromEPtrs(); });
+	Bench::run("printAt(line, String)", stream, iterations, [] { printAtFromEPtrs("Hello World"); });
+	Bench::run("printAt(line, double)", stream, iterations, [] { printNumberFromEPtrs(); });
+	Bench::run("Sensor::start", stream, iterations, [] { sensorStartFromEPtrs(); });
+
+	return 0;
+}
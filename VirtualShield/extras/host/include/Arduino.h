@@ -0,0 +1,205 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// A host (Linux) stand-in for the parts of the Arduino core the library uses, so it builds and runs off-target.
+// PROGMEM is ordinary memory, millis() follows a clock the tests control (see Host.h) and Serial discards output.
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uintptr_t uint_farptr_t;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+
+#define SERIAL_TX_BUFFER_SIZE 64
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t*>(address))
+#define pgm_read_byte_near(address) pgm_read_byte(address)
+#define pgm_read_word(address) (*reinterpret_cast<const uint16_t*>(address))
+#define pgm_read_dword(address) (*reinterpret_cast<const uint32_t*>(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+#define strlen_P strlen
+#define strlen_PF(address) strlen(reinterpret_cast<const char*>(address))
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(PSTR(s)))
+
+template <typename T, typename U>
+auto min(const T& a, const U& b) -> decltype(a < b ? a : b)
+{
+	return b < a ? b : a;
+}
+
+template <typename T, typename U>
+auto max(const T& a, const U& b) -> decltype(a < b ? b : a)
+{
+	return a < b ? b : a;
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+// Like Arduino's String, one made from a null pointer is invalid: it tests false and c_str() is null.
+class String
+{
+	typedef void (String::*StringIfHelperType)() const;
+	void StringIfHelper() const {}
+
+public:
+	String(const char* text = "");
+	String(const __FlashStringHelper* text);
+	String(const String& other);
+	explicit String(char c);
+	explicit String(int value, unsigned char base = DEC);
+	explicit String(unsigned int value, unsigned char base = DEC);
+	explicit String(long value, unsigned char base = DEC);
+	explicit String(unsigned long value, unsigned char base = DEC);
+	explicit String(double value, unsigned char decimals = 2);
+	~String();
+
+	String& operator=(const String& other);
+	String& operator=(const char* text);
+	String& operator+=(const String& other) { if (other.buffer) concat(other.buffer, other.len); return *this; }
+	String& operator+=(const char* text) { if (text) concat(text, strlen(text)); return *this; }
+	String& operator+=(char c) { concat(&c, 1); return *this; }
+
+	friend String operator+(const String& a, const String& b) { String sum(a); sum += b; return sum; }
+	friend String operator+(const String& a, const char* b) { String sum(a); sum += b; return sum; }
+	friend String operator+(const char* a, const String& b) { String sum(a); sum += b; return sum; }
+
+	bool operator==(const String& other) const { return equals(other.c_str()); }
+	bool operator==(const char* text) const { return equals(text); }
+	bool operator!=(const String& other) const { return !equals(other.c_str()); }
+	bool operator!=(const char* text) const { return !equals(text); }
+
+	operator StringIfHelperType() const { return buffer ? &String::StringIfHelper : 0; }
+
+	bool equals(const char* text) const { return strcmp(buffer ? buffer : "", text ? text : "") == 0; }
+	const char* c_str() const { return buffer; }
+	unsigned int length() const { return len; }
+	char charAt(unsigned int index) const { return index < len ? buffer[index] : 0; }
+	char operator[](unsigned int index) const { return charAt(index); }
+	char& operator[](unsigned int index) { return buffer[index]; }
+	int indexOf(char c, unsigned int from = 0) const;
+	String substring(unsigned int from, unsigned int to = 0xFFFF) const;
+	long toInt() const { return buffer ? atol(buffer) : 0; }
+
+private:
+	char* buffer = 0;
+	unsigned int len = 0;
+
+	void assign(const char* text, unsigned int length);
+	void concat(const char* text, unsigned int length);
+};
+
+class Print
+{
+public:
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t* data, size_t size);
+	size_t write(const char* text) { return text ? write(reinterpret_cast<const uint8_t*>(text), strlen(text)) : 0; }
+	size_t write(const char* data, size_t size) { return write(reinterpret_cast<const uint8_t*>(data), size); }
+	virtual int availableForWrite() { return 0; }
+	virtual void flush() {}
+
+	size_t print(const __FlashStringHelper* text) { return write(reinterpret_cast<const char*>(text)); }
+	size_t print(const String& text) { return write(text.c_str()); }
+	size_t print(const char* text) { return write(text); }
+	size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+	size_t print(int value, int base = DEC) { return print(static_cast<long>(value), base); }
+	size_t print(unsigned int value, int base = DEC) { return print(static_cast<unsigned long>(value), base); }
+	size_t print(long value, int base = DEC);
+	size_t print(unsigned long value, int base = DEC);
+	size_t print(double value, int digits = 2);
+
+	template <typename T>
+	size_t println(const T& value) { size_t n = print(value); return n + println(); }
+	size_t println() { return write("\r\n"); }
+};
+
+class Stream : public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+};
+
+// A serial port that receives nothing and discards what is written to it.
+class HardwareSerial : public Stream
+{
+public:
+	void begin(unsigned long baud) { this->baud = baud; }
+	void end() {}
+	int available() override { return 0; }
+	int read() override { return -1; }
+	int peek() override { return -1; }
+	size_t write(uint8_t) override { return 1; }
+	size_t write(const uint8_t*, size_t size) override { return size; }
+	using Print::write;
+	int availableForWrite() override { return SERIAL_TX_BUFFER_SIZE - 1; }
+	operator bool() const { return true; }
+
+	unsigned long baud = 0;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,59 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Controls of the host build: the clock behind millis() and micros(), and the heap counters.
+
+#ifndef Host_h
+#define Host_h
+
+#include "Arduino.h"
+
+class Host
+{
+public:
+	static void setMillis(unsigned long ms);
+	static void advance(unsigned long ms);
+	static void setClockStep(unsigned long microsPerRead);
+
+	static unsigned long allocations();
+	static unsigned long allocatedBytes();
+	static unsigned long releases();
+	static void resetAllocations();
+	static bool countsAllocations();
+
+	static void pauseAllocationCount();
+	static void resumeAllocationCount();
+};
+
+/// <summary>
+/// Leaves the allocations of the harness itself (recording streams, test scaffolding) out of the heap counters.
+/// </summary>
+class HostUncounted
+{
+public:
+	HostUncounted() { Host::pauseAllocationCount(); }
+	~HostUncounted() { Host::resumeAllocationCount(); }
+};
+
+#endif
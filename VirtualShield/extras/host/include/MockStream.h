@@ -0,0 +1,139 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// A stream standing in for the remote device: it records what the shield writes, with timestamps,
+// and plays back what the test queues for the shield to read.
+
+#ifndef MockStream_h
+#define MockStream_h
+
+#include "Arduino.h"
+#include "Host.h"
+
+#include <string>
+#include <vector>
+
+struct MockWrite
+{
+	unsigned long micros;
+	size_t offset;
+	size_t size;
+};
+
+class MockStream : public Stream
+{
+public:
+	std::string output;
+	std::vector<MockWrite> writes;
+	int flushes = 0;
+	int writeSpace = SERIAL_TX_BUFFER_SIZE - 1;
+
+	/// <summary>
+	/// Queues bytes for the shield to read.
+	/// </summary>
+	void receive(const char* data, size_t size)
+	{
+		HostUncounted uncounted;
+		input.append(data, size);
+	}
+
+	void receive(const char* text)
+	{
+		receive(text, strlen(text));
+	}
+
+	/// <summary>
+	/// Returns what was written since the last take and forgets it.
+	/// </summary>
+	std::string take()
+	{
+		HostUncounted uncounted;
+		std::string written;
+		written.swap(output);
+		writes.clear();
+		return written;
+	}
+
+	void clear()
+	{
+		HostUncounted uncounted;
+		output.clear();
+		writes.clear();
+		input.clear();
+		position = 0;
+		flushes = 0;
+	}
+
+	size_t pendingInput() const
+	{
+		return input.size() - position;
+	}
+
+	size_t write(uint8_t c) override
+	{
+		return write(&c, 1);
+	}
+
+	size_t write(const uint8_t* data, size_t size) override
+	{
+		HostUncounted uncounted;
+		MockWrite record = { micros(), output.size(), size };
+		writes.push_back(record);
+		output.append(reinterpret_cast<const char*>(data), size);
+		return size;
+	}
+
+	using Print::write;
+
+	int availableForWrite() override
+	{
+		return writeSpace;
+	}
+
+	void flush() override
+	{
+		flushes++;
+	}
+
+	int available() override
+	{
+		return static_cast<int>(input.size() - position);
+	}
+
+	int read() override
+	{
+		return position < input.size() ? static_cast<uint8_t>(input[position++]) : -1;
+	}
+
+	int peek() override
+	{
+		return position < input.size() ? static_cast<uint8_t>(input[position]) : -1;
+	}
+
+private:
+	std::string input;
+	size_t position = 0;
+};
+
+#endif
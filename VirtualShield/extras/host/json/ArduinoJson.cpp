@@ -0,0 +1,354 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "ArduinoJson.h"
+
+namespace ArduinoJson {
+
+/// <summary>
+/// Gets the variant as text; numbers and booleans have none, unparsed text is returned as is (except null).
+/// </summary>
+const char* JsonVariant::asText() const
+{
+	if (type == Unparsed && strcmp(content.text, "null") == 0)
+	{
+		return 0;
+	}
+
+	return type == Text || type == Unparsed ? content.text : 0;
+}
+
+/// <summary>
+/// Gets the variant as an integer; text is parsed, true is 1.
+/// </summary>
+long JsonVariant::asInteger() const
+{
+	switch (type)
+	{
+	case Boolean:
+	case Integer:
+		return content.integer;
+	case Float:
+		return static_cast<long>(content.real);
+	case Text:
+	case Unparsed:
+		return strcmp(content.text, "true") == 0 ? 1 : strtol(content.text, 0, 10);
+	default:
+		return 0;
+	}
+}
+
+/// <summary>
+/// Gets the variant as a real number; text is parsed, true is 1.
+/// </summary>
+double JsonVariant::asReal() const
+{
+	switch (type)
+	{
+	case Boolean:
+	case Integer:
+		return content.integer;
+	case Float:
+		return content.real;
+	case Text:
+	case Unparsed:
+		return strcmp(content.text, "true") == 0 ? 1 : strtod(content.text, 0);
+	default:
+		return 0;
+	}
+}
+
+JsonVariant JsonObject::get(const char* key) const
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (strcmp(pairs[i].key, key) == 0)
+		{
+			return pairs[i].value;
+		}
+	}
+
+	return JsonVariant();
+}
+
+bool JsonObject::containsKey(const char* key) const
+{
+	return get(key).success();
+}
+
+/// <summary>
+/// Sets the value of a key. The key is not copied.
+/// </summary>
+bool JsonObject::set(const char* key, const JsonVariant& value)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (strcmp(pairs[i].key, key) == 0)
+		{
+			pairs[i].value = value;
+			return true;
+		}
+	}
+
+	if (count == maxJsonPairs)
+	{
+		return false;
+	}
+
+	pairs[count].key = key;
+	pairs[count].value = value;
+	count++;
+	return true;
+}
+
+JsonObject& JsonObject::invalid()
+{
+	static JsonObject object;
+	object.count = 0;
+	object.valid = false;
+	return object;
+}
+
+static char* skipSpaces(char* scanner)
+{
+	while (*scanner == ' ' || *scanner == '\t' || *scanner == '\r' || *scanner == '\n')
+	{
+		scanner++;
+	}
+
+	return scanner;
+}
+
+/// <summary>
+/// Unescapes a quoted string in place. Returns the position after the closing quote, or 0 if it is not closed.
+/// </summary>
+static char* readString(char* scanner, char** text)
+{
+	char quote = *scanner++;
+	char* writer = scanner;
+	*text = scanner;
+
+	while (*scanner != quote)
+	{
+		char c = *scanner++;
+		if (c == 0)
+		{
+			return 0;
+		}
+
+		if (c == '\\')
+		{
+			c = *scanner++;
+			switch (c)
+			{
+			case 'n': c = '\n'; break;
+			case 'r': c = '\r'; break;
+			case 't': c = '\t'; break;
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case 'u':
+			{
+				char digits[5] = { 0 };
+				for (int i = 0; i < 4 && *scanner; i++)
+				{
+					digits[i] = *scanner++;
+				}
+
+				c = static_cast<char>(strtol(digits, 0, 16));
+				break;
+			}
+			case 0:
+				return 0;
+			}
+		}
+
+		*writer++ = c;
+	}
+
+	*writer = 0;
+	return scanner + 1;
+}
+
+/// <summary>
+/// Reads a nested object or array, which is kept as unparsed text.
+/// </summary>
+static char* readNested(char* scanner)
+{
+	int depth = 0;
+	do
+	{
+		switch (*scanner)
+		{
+		case 0:
+			return 0;
+		case '{':
+		case '[':
+			depth++;
+			break;
+		case '}':
+		case ']':
+			depth--;
+			break;
+		case '\'':
+		case '"':
+		{
+			char* text;
+			scanner = readString(scanner, &text);
+			if (!scanner)
+			{
+				return 0;
+			}
+
+			continue;
+		}
+		}
+
+		scanner++;
+	} while (depth > 0);
+
+	return scanner;
+}
+
+bool JsonObjectParser::parse(char* json, JsonObject& object)
+{
+	char* scanner = skipSpaces(json);
+	if (*scanner++ != '{')
+	{
+		return false;
+	}
+
+	scanner = skipSpaces(scanner);
+	if (*scanner == '}')
+	{
+		return true;
+	}
+
+	for (;;)
+	{
+		if (*scanner != '\'' && *scanner != '"')
+		{
+			return false;
+		}
+
+		char* key;
+		scanner = readString(scanner, &key);
+		if (!scanner)
+		{
+			return false;
+		}
+
+		scanner = skipSpaces(scanner);
+		if (*scanner++ != ':')
+		{
+			return false;
+		}
+
+		scanner = skipSpaces(scanner);
+		JsonVariant value;
+		char next;
+		if (*scanner == '\'' || *scanner == '"')
+		{
+			char* text;
+			scanner = readString(scanner, &text);
+			if (!scanner)
+			{
+				return false;
+			}
+
+			value = JsonVariant(static_cast<const char*>(text));
+			scanner = skipSpaces(scanner);
+			next = *scanner;
+		}
+		else
+		{
+			char* start = scanner;
+			if (*scanner == '{' || *scanner == '[')
+			{
+				scanner = readNested(scanner);
+				if (!scanner)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				while (*scanner && *scanner != ',' && *scanner != '}' && *scanner != ' ')
+				{
+					scanner++;
+				}
+			}
+
+			// the separator is read before the value is terminated, which may overwrite it
+			char* end = scanner;
+			scanner = skipSpaces(scanner);
+			next = *scanner;
+			*end = 0;
+
+			if (strcmp(start, "true") == 0 || strcmp(start, "false") == 0)
+			{
+				value = JsonVariant(*start == 't');
+			}
+			else if (*start == '{' || *start == '[' || strcmp(start, "null") == 0)
+			{
+				value = JsonVariant(RawJson(start));
+			}
+			else
+			{
+				char* numberEnd;
+				if (strpbrk(start, ".eE"))
+				{
+					value = JsonVariant(strtod(start, &numberEnd));
+				}
+				else
+				{
+					value = JsonVariant(strtol(start, &numberEnd, 10));
+				}
+
+				if (numberEnd == start || *numberEnd)
+				{
+					return false;
+				}
+			}
+		}
+
+		if (!object.set(key, value))
+		{
+			return false;
+		}
+
+		if (next == '}')
+		{
+			return true;
+		}
+
+		if (next != ',')
+		{
+			return false;
+		}
+
+		scanner = skipSpaces(scanner + 1);
+	}
+}
+
+}
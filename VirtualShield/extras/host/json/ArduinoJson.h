@@ -0,0 +1,172 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// A stand-in for the subset of the ArduinoJson 5 API the library uses (StaticJsonBuffer, JsonObject, JsonVariant,
+// RawJson), for host builds where the real library is not installed. Configure with -DARDUINOJSON_DIR=<path to
+// ArduinoJson 5's src folder> to build against the real one instead.
+// Like ArduinoJson, parseObject works in place: keys and strings point into the parsed buffer.
+
+#ifndef ArduinoJson_h
+#define ArduinoJson_h
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace ArduinoJson {
+
+// The most pairs an object holds; set() fails (and a parse fails) beyond it.
+const int maxJsonPairs = 24;
+
+struct RawJsonString
+{
+	const char* text;
+};
+
+inline RawJsonString RawJson(const char* text)
+{
+	RawJsonString raw = { text };
+	return raw;
+}
+
+class JsonVariant
+{
+public:
+	JsonVariant() : type(Undefined) {}
+	JsonVariant(const char* value) : type(value ? Text : Undefined) { content.text = value; }
+	JsonVariant(RawJsonString value) : type(value.text ? Unparsed : Undefined) { content.text = value.text; }
+	JsonVariant(bool value) : type(Boolean) { content.integer = value; }
+	JsonVariant(int value) : type(Integer) { content.integer = value; }
+	JsonVariant(unsigned int value) : type(Integer) { content.integer = value; }
+	JsonVariant(long value) : type(Integer) { content.integer = value; }
+	JsonVariant(unsigned long value) : type(Integer) { content.integer = static_cast<long>(value); }
+	JsonVariant(float value) : type(Float) { content.real = value; }
+	JsonVariant(double value) : type(Float) { content.real = value; }
+
+	operator const char*() const { return asText(); }
+	operator bool() const { return asInteger() != 0; }
+	operator char() const { return static_cast<char>(asInteger()); }
+	operator int() const { return static_cast<int>(asInteger()); }
+	operator unsigned int() const { return static_cast<unsigned int>(asInteger()); }
+	operator long() const { return asInteger(); }
+	operator unsigned long() const { return static_cast<unsigned long>(asInteger()); }
+	operator float() const { return static_cast<float>(asReal()); }
+	operator double() const { return asReal(); }
+
+	template <typename T>
+	T as() const
+	{
+		return static_cast<T>(*this);
+	}
+
+	bool success() const
+	{
+		return type != Undefined;
+	}
+
+private:
+	enum Type { Undefined, Text, Unparsed, Boolean, Integer, Float };
+
+	Type type;
+	union
+	{
+		const char* text;
+		long integer;
+		double real;
+	} content;
+
+	const char* asText() const;
+	long asInteger() const;
+	double asReal() const;
+};
+
+struct JsonPair
+{
+	const char* key;
+	JsonVariant value;
+};
+
+class JsonObject
+{
+public:
+	typedef JsonPair* iterator;
+	typedef const JsonPair* const_iterator;
+
+	iterator begin() { return pairs; }
+	iterator end() { return pairs + count; }
+	const_iterator begin() const { return pairs; }
+	const_iterator end() const { return pairs + count; }
+
+	bool success() const { return valid; }
+	size_t size() const { return count; }
+
+	JsonVariant operator[](const char* key) const { return get(key); }
+	JsonVariant get(const char* key) const;
+	bool containsKey(const char* key) const;
+	bool set(const char* key, const JsonVariant& value);
+
+	static JsonObject& invalid();
+
+private:
+	friend class JsonObjectParser;
+
+	JsonPair pairs[maxJsonPairs];
+	int count = 0;
+	bool valid = true;
+};
+
+// Parses a single object in place. Nested objects and arrays are kept as unparsed text.
+class JsonObjectParser
+{
+public:
+	static bool parse(char* json, JsonObject& object);
+};
+
+template <size_t Capacity>
+class StaticJsonBuffer
+{
+public:
+	JsonObject& createObject()
+	{
+		object = JsonObject();
+		return object;
+	}
+
+	JsonObject& parseObject(char* json)
+	{
+		JsonObject& parsed = createObject();
+		return json && JsonObjectParser::parse(json, parsed) ? parsed : JsonObject::invalid();
+	}
+
+	size_t capacity() const { return Capacity; }
+
+private:
+	JsonObject object;
+};
+
+}
+
+using namespace ArduinoJson;
+
+#endif
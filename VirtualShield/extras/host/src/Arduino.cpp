@@ -0,0 +1,489 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "Host.h"
+
+HardwareSerial Serial;
+
+static unsigned long long clockMicros = 0;
+static unsigned long clockStep = 0;
+static uint8_t pins[64];
+static unsigned long randomState = 1;
+
+static unsigned long allocationCount = 0;
+static unsigned long allocationBytes = 0;
+static unsigned long releaseCount = 0;
+static int allocationPauses = 0;
+
+unsigned long millis()
+{
+	unsigned long ms = static_cast<unsigned long>(clockMicros / 1000);
+	clockMicros += clockStep;
+	return ms;
+}
+
+unsigned long micros()
+{
+	unsigned long us = static_cast<unsigned long>(clockMicros);
+	clockMicros += clockStep;
+	return us;
+}
+
+void delay(unsigned long ms)
+{
+	clockMicros += ms * 1000ULL;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	clockMicros += us;
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	pins[pin & 63] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+	return pins[pin & 63];
+}
+
+int analogRead(uint8_t)
+{
+	return 0;
+}
+
+void analogWrite(uint8_t pin, int value)
+{
+	pins[pin & 63] = value != 0;
+}
+
+void randomSeed(unsigned long seed)
+{
+	randomState = seed ? seed : 1;
+}
+
+long random(long howBig)
+{
+	if (howBig <= 0)
+	{
+		return 0;
+	}
+
+	randomState = randomState * 1103515245UL + 12345UL;
+	return static_cast<long>((randomState >> 8) % static_cast<unsigned long>(howBig));
+}
+
+long random(long howSmall, long howBig)
+{
+	return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+void Host::setMillis(unsigned long ms)
+{
+	clockMicros = ms * 1000ULL;
+}
+
+/// <summary>
+/// Moves the clock forward, as if the sketch had been busy for a while.
+/// </summary>
+void Host::advance(unsigned long ms)
+{
+	clockMicros += ms * 1000ULL;
+}
+
+/// <summary>
+/// Makes every millis() or micros() read move the clock forward, so loops waiting for time (a blocking waitFor) end.
+/// Zero (the default) stops the clock between explicit advances.
+/// </summary>
+void Host::setClockStep(unsigned long microsPerRead)
+{
+	clockStep = microsPerRead;
+}
+
+unsigned long Host::allocations()
+{
+	return allocationCount;
+}
+
+unsigned long Host::allocatedBytes()
+{
+	return allocationBytes;
+}
+
+unsigned long Host::releases()
+{
+	return releaseCount;
+}
+
+void Host::resetAllocations()
+{
+	allocationCount = 0;
+	allocationBytes = 0;
+	releaseCount = 0;
+}
+
+/// <summary>
+/// Whether heap use is counted; it is not in sanitizer builds, which replace the allocator themselves.
+/// </summary>
+bool Host::countsAllocations()
+{
+#ifdef VIRTUAL_SHIELD_HOST_SANITIZE
+	return false;
+#else
+	return true;
+#endif
+}
+
+void Host::pauseAllocationCount()
+{
+	allocationPauses++;
+}
+
+void Host::resumeAllocationCount()
+{
+	allocationPauses--;
+}
+
+#ifndef VIRTUAL_SHIELD_HOST_SANITIZE
+
+// Every heap use (malloc, new, String) goes through these, which count it and forward to the C library.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* block, size_t size);
+void __libc_free(void* block);
+
+void* malloc(size_t size)
+{
+	if (allocationPauses == 0)
+	{
+		allocationCount++;
+		allocationBytes += size;
+	}
+
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+	if (allocationPauses == 0)
+	{
+		allocationCount++;
+		allocationBytes += count * size;
+	}
+
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* block, size_t size)
+{
+	if (allocationPauses == 0)
+	{
+		allocationCount++;
+		allocationBytes += size;
+	}
+
+	return __libc_realloc(block, size);
+}
+
+void free(void* block)
+{
+	if (block && allocationPauses == 0)
+	{
+		releaseCount++;
+	}
+
+	__libc_free(block);
+}
+}
+
+#endif
+
+size_t Print::write(const uint8_t* data, size_t size)
+{
+	size_t written = 0;
+	while (size--)
+	{
+		written += write(*data++);
+	}
+
+	return written;
+}
+
+// The numbers are formatted like the Arduino core does (no printf, which takes kilobytes of stack).
+size_t Print::print(long value, int base)
+{
+	if (base == DEC && value < 0)
+	{
+		return print('-') + print(0UL - static_cast<unsigned long>(value), base);
+	}
+
+	return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+	char text[8 * sizeof(long) + 1];
+	char* digit = text + sizeof(text) - 1;
+	*digit = 0;
+	if (base < 2)
+	{
+		base = DEC;
+	}
+
+	do
+	{
+		int remainder = static_cast<int>(value % base);
+		*--digit = static_cast<char>(remainder < 10 ? '0' + remainder : 'A' + remainder - 10);
+		value /= base;
+	} while (value);
+
+	return write(digit);
+}
+
+size_t Print::print(double value, int digits)
+{
+	if (isnan(value))
+	{
+		return write("nan");
+	}
+
+	if (isinf(value))
+	{
+		return write("inf");
+	}
+
+	if (value > 4294967040.0 || value < -4294967040.0)
+	{
+		return write("ovf");
+	}
+
+	size_t written = 0;
+	if (value < 0.0)
+	{
+		written += print('-');
+		value = -value;
+	}
+
+	double rounding = 0.5;
+	for (int i = 0; i < digits; i++)
+	{
+		rounding /= 10.0;
+	}
+
+	value += rounding;
+	unsigned long integer = static_cast<unsigned long>(value);
+	double remainder = value - integer;
+	written += print(integer);
+	if (digits > 0)
+	{
+		written += print('.');
+	}
+
+	while (digits-- > 0)
+	{
+		remainder *= 10.0;
+		int digit = static_cast<int>(remainder);
+		written += print(static_cast<char>('0' + digit));
+		remainder -= digit;
+	}
+
+	return written;
+}
+
+String::String(const char* text)
+{
+	if (text)
+	{
+		assign(text, strlen(text));
+	}
+}
+
+String::String(const __FlashStringHelper* text)
+{
+	const char* chars = reinterpret_cast<const char*>(text);
+	if (chars)
+	{
+		assign(chars, strlen(chars));
+	}
+}
+
+String::String(const String& other)
+{
+	if (other.buffer)
+	{
+		assign(other.buffer, other.len);
+	}
+}
+
+String::String(char c)
+{
+	assign(&c, 1);
+}
+
+String::String(int value, unsigned char base)
+	: String(static_cast<long>(value), base)
+{
+}
+
+String::String(unsigned int value, unsigned char base)
+	: String(static_cast<unsigned long>(value), base)
+{
+}
+
+String::String(long value, unsigned char base)
+{
+	char text[72];
+	if (base == DEC)
+	{
+		snprintf(text, sizeof(text), "%ld", value);
+	}
+	else
+	{
+		unsigned long magnitude = static_cast<unsigned long>(value);
+		char* digit = text + sizeof(text) - 1;
+		*digit = 0;
+		do
+		{
+			int remainder = static_cast<int>(magnitude % base);
+			*--digit = static_cast<char>(remainder < 10 ? '0' + remainder : 'a' + remainder - 10);
+			magnitude /= base;
+		} while (magnitude);
+
+		memmove(text, digit, strlen(digit) + 1);
+	}
+
+	assign(text, strlen(text));
+}
+
+String::String(unsigned long value, unsigned char base)
+{
+	char text[72];
+	char* digit = text + sizeof(text) - 1;
+	*digit = 0;
+	do
+	{
+		int remainder = static_cast<int>(value % base);
+		*--digit = static_cast<char>(remainder < 10 ? '0' + remainder : 'a' + remainder - 10);
+		value /= base;
+	} while (value);
+
+	assign(digit, strlen(digit));
+}
+
+String::String(double value, unsigned char decimals)
+{
+	char text[48];
+	snprintf(text, sizeof(text), "%.*f", decimals, value);
+	assign(text, strlen(text));
+}
+
+String::~String()
+{
+	free(buffer);
+}
+
+String& String::operator=(const String& other)
+{
+	if (this != &other)
+	{
+		if (other.buffer)
+		{
+			assign(other.buffer, other.len);
+		}
+		else
+		{
+			free(buffer);
+			buffer = 0;
+			len = 0;
+		}
+	}
+
+	return *this;
+}
+
+String& String::operator=(const char* text)
+{
+	String copy(text);
+	return *this = copy;
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+	if (!buffer || from >= len)
+	{
+		return -1;
+	}
+
+	const char* found = strchr(buffer + from, c);
+	return found ? static_cast<int>(found - buffer) : -1;
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+	if (from > to)
+	{
+		unsigned int swap = from;
+		from = to;
+		to = swap;
+	}
+
+	String part;
+	if (from < len)
+	{
+		part.assign(buffer + from, (to > len ? len : to) - from);
+	}
+
+	return part;
+}
+
+void String::assign(const char* text, unsigned int length)
+{
+	// the text may be part of this string
+	char* copy = static_cast<char*>(malloc(length + 1));
+	memcpy(copy, text, length);
+	copy[length] = 0;
+	free(buffer);
+	buffer = copy;
+	len = length;
+}
+
+void String::concat(const char* text, unsigned int length)
+{
+	// the text may be part of this string, which realloc can move
+	bool isOwnText = buffer && text >= buffer && text <= buffer + len;
+	size_t offset = isOwnText ? text - buffer : 0;
+	char* joined = static_cast<char*>(realloc(buffer, len + length + 1));
+	memcpy(joined + len, isOwnText ? joined + offset : text, length);
+	joined[len + length] = 0;
+	buffer = joined;
+	len += length;
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Graphics.h"
+#include "Accelerometer.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static Accelerometer accelerometer(shield);
+
+static const long eventCount = 10000;
+
+// Receives a message and dispatches every event it holds; the result is the count of events.
+static int dispatch(const char* message)
+{
+	stream.receive(message);
+
+	int count = 0;
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+		count++;
+	}
+
+	return count;
+}
+
+TEST(sensorEventsDoNotAllocate)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	stream.take();
+
+	Host::resetAllocations();
+	int received = 0;
+	for (long i = 0; i < eventCount; i++)
+	{
+		received += dispatch("{'Type':'A','Id':5,'X':0.5,'Y':-1,'Z':2}");
+	}
+
+	CHECK_EQUAL(static_cast<int>(eventCount), received);
+	if (Host::countsAllocations())
+	{
+		CHECK_EQUAL(0ul, Host::allocations());
+	}
+}
+
+TEST(screenEventsDoNotAllocate)
+{
+	Host::resetAllocations();
+	int received = 0;
+	for (long i = 0; i < eventCount; i++)
+	{
+		received += dispatch("{'Type':'S','Id':7,'Tag':'go','Action':'pressed','X':10,'Y':20}");
+	}
+
+	CHECK_EQUAL(static_cast<int>(eventCount), received);
+	if (Host::countsAllocations())
+	{
+		CHECK_EQUAL(0ul, Host::allocations());
+	}
+}
+
+TEST(pingsDoNotAllocate)
+{
+	Host::resetAllocations();
+	for (long i = 0; i < eventCount; i++)
+	{
+		dispatch("{'Type':'!','Result':'PING'}");
+		stream.clear();
+	}
+
+	if (Host::countsAllocations())
+	{
+		CHECK_EQUAL(0ul, Host::allocations());
+	}
+}
+
+int main()
+{
+	return HostTest::run();
+}
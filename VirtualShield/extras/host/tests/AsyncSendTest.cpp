@@ -0,0 +1,71 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Text.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Text screen(shield);
+static MockStream roomy;
+
+TEST(aStreamThatNeverReportsRoomIsWrittenBlocking)
+{
+	stream.writeSpace = 0;
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	shield.enableAsyncSend(true);
+	stream.take();
+
+	screen.printAt(1, "sent");
+	CHECK(stream.take().find("'Message':'sent'") != std::string::npos);
+}
+
+TEST(aStreamReportingRoomIsWrittenAsRoomAllows)
+{
+	roomy.writeSpace = 63;
+	shield.begin(roomy);
+	roomy.take();
+	roomy.writeSpace = 10;
+
+	screen.printAt(1, "queued");
+	CHECK_EQUAL(10u, roomy.take().size());
+
+	// a full transmit buffer leaves the rest queued
+	roomy.writeSpace = 0;
+	ShieldEvent event;
+	shield.getEvent(&event);
+	CHECK_EQUAL(0u, roomy.take().size());
+
+	roomy.writeSpace = 63;
+	shield.getEvent(&event);
+	CHECK(roomy.take().find("'Message':'queued'") != std::string::npos);
+}
+
+int main()
+{
+	return HostTest::run();
+}
@@ -0,0 +1,142 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Text.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Text screen(shield);
+
+static void receive(const char* message)
+{
+	stream.receive(message);
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+}
+
+static int count(const std::string& text, const char* part)
+{
+	int found = 0;
+	for (size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + 1))
+	{
+		found++;
+	}
+
+	return found;
+}
+
+TEST(startOffersBatches)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	CHECK(stream.take().find("'Batch':1") != std::string::npos);
+}
+
+TEST(withoutSupportMessagesAreSentOneByOne)
+{
+	CHECK_EQUAL(0, shield.beginBatch());
+	screen.printAt(1, "one");
+	screen.printAt(2, "two");
+	CHECK_EQUAL(0, shield.commitBatch());
+
+	CHECK_EQUAL(2u, stream.writes.size());
+	std::string written = stream.take();
+	CHECK_EQUAL(0, count(written, "BATCH"));
+	CHECK_EQUAL(2, count(written, "'Service':'LCDT'"));
+}
+
+TEST(withSupportMessagesAreSentAsOneBatch)
+{
+	receive("{'Type':'!','Result':'BATCH'}");
+	int id = shield.beginBatch();
+	CHECK(id > 0);
+	screen.printAt(1, "one");
+	screen.printAt(2, "two");
+	CHECK_EQUAL(id, shield.commitBatch());
+
+	std::string written = stream.take();
+	CHECK_EQUAL(0u, written.find("{'Service':'BATCH'"));
+	CHECK_EQUAL(1, count(written, "'Service':'BATCH'"));
+	CHECK_EQUAL(2, count(written, "'Service':'LCDT'"));
+	CHECK_EQUAL("]}", written.substr(written.size() - 2));
+}
+
+TEST(pongIsHeldUntilTheBatchIsCommitted)
+{
+	shield.beginBatch();
+	screen.printAt(1, "one");
+	receive("{'Type':'!','Result':'PING'}");
+	screen.printAt(2, "two");
+	CHECK(stream.output.find("PONG") == std::string::npos);
+
+	shield.commitBatch();
+	std::string written = stream.take();
+	size_t batchEnd = written.find("]}");
+	CHECK(batchEnd != std::string::npos);
+	CHECK(written.find("PONG") > batchEnd);
+	CHECK_EQUAL(1, count(written, "PONG"));
+	CHECK_EQUAL(2, count(written.substr(0, batchEnd), "'Service':'LCDT'"));
+}
+
+TEST(codecChangeIsHeldUntilTheBatchIsCommitted)
+{
+	shield.beginBatch();
+	screen.printAt(1, "one");
+	receive("{'Type':'!','Result':'CODEC','Value':1}");
+	screen.printAt(2, "two");
+	shield.commitBatch();
+
+	// the whole batch is JSON, the next message CBOR
+	std::string written = stream.take();
+	CHECK_EQUAL(0u, written.find("{'Service':'BATCH'"));
+	CHECK_EQUAL("]}", written.substr(written.size() - 2));
+
+	screen.printAt(3, "three");
+	CHECK_EQUAL(0xBF, static_cast<uint8_t>(stream.take()[0]));
+}
+
+TEST(connectDuringABatchRestartsTheHandshakeAfterIt)
+{
+	int id = shield.beginBatch();
+	screen.printAt(1, "one");
+	receive("{'Type':'!','Result':'CONNECT'}");
+	CHECK(stream.output.find("START") == std::string::npos);
+	CHECK_EQUAL(id, shield.commitBatch());
+
+	// the batch is encoded as it began (CBOR), then the new handshake resets to JSON without batches
+	std::string written = stream.take();
+	CHECK_EQUAL(0xBF, static_cast<uint8_t>(written[0]));
+	CHECK(written.find("'Action':'START'") != std::string::npos);
+	CHECK_EQUAL(0, shield.beginBatch());
+}
+
+int main()
+{
+	return HostTest::run();
+}
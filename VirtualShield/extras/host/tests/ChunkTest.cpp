@@ -0,0 +1,113 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Graphics.h"
+
+#include <string>
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static char queue[256];
+static char chunks[128];
+static std::string order;
+
+static void onEvent(ShieldEvent* shieldEvent)
+{
+	if (shieldEvent->result && shieldEvent->result[0] != 'C')
+	{
+		order += shieldEvent->result;
+		order += ' ';
+	}
+}
+
+// Dispatches every event received so far.
+static void dispatchAll()
+{
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+}
+
+static const char* const firstChunk = "{'Type':'!','Result':'CHUNK','Id':30,'Value':0,'Action':'MORE','Data':'{\"Type\":\"S\",\"Id\":30,'}";
+static const char* const lastChunk = "{'Type':'!','Result':'CHUNK','Id':30,'Value':1,'Action':'LAST','Data':'\"Result\":\"big\"}'}";
+
+TEST(aReassembledMessageIsDispatched)
+{
+	shield.enableAutoBlocking(false);
+	shield.setChunkBuffer(chunks, sizeof(chunks));
+	shield.setOnEvent(onEvent);
+	shield.begin(stream);
+
+	stream.receive(firstChunk);
+	stream.receive(lastChunk);
+	dispatchAll();
+
+	CHECK_EQUAL(std::string("big "), order);
+	CHECK_EQUAL(0, shield.droppedChunks);
+}
+
+TEST(aReassembledMessageWaitsForTheMessagesQueuedBeforeIt)
+{
+	shield.setReceiveQueue(queue, sizeof(queue));
+	order.clear();
+
+	stream.receive("{'Type':'S','Id':31,'Result':'one'}{'Type':'S','Id':32,'Result':'two'}");
+	shield.poll();
+	stream.receive(firstChunk);
+	stream.receive(lastChunk);
+	stream.receive("{'Type':'S','Id':33,'Result':'three'}");
+	dispatchAll();
+
+	CHECK_EQUAL(std::string("one two big three "), order);
+}
+
+TEST(aNewMessageIsDroppedWhileTheLastOneWaits)
+{
+	order.clear();
+
+	stream.receive("{'Type':'S','Id':34,'Result':'one'}");
+	shield.poll();
+	stream.receive(firstChunk);
+	stream.receive(lastChunk);
+	ShieldEvent event;
+	shield.getEvent(&event);
+	shield.getEvent(&event);
+	CHECK_EQUAL(std::string(""), order);
+
+	stream.receive(firstChunk);
+	dispatchAll();
+
+	CHECK_EQUAL(std::string("one big "), order);
+	CHECK_EQUAL(1, shield.droppedChunks);
+}
+
+int main()
+{
+	return HostTest::run();
+}
@@ -0,0 +1,100 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Text.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Text screen(shield);
+
+static void receive(const char* message)
+{
+	stream.receive(message);
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+}
+
+TEST(startOffersCborWithoutTheDictionary)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	std::string start = stream.take();
+	CHECK(start.find("'Codec':'CBOR'") != std::string::npos);
+	CHECK(start.find("Dict") == std::string::npos);
+}
+
+TEST(cborWithoutTokensSendsNoDictionary)
+{
+	receive("{'Type':'!','Result':'CODEC','Value':1}");
+	CHECK_EQUAL("", stream.take());
+
+	screen.printAt(1, "Hi");
+	std::string written = stream.take();
+	CHECK_EQUAL(0xBF, static_cast<uint8_t>(written[0]));
+	CHECK(written.find("Message") != std::string::npos);
+}
+
+TEST(tokensAreUsedAfterTheDictionaryWasSent)
+{
+	receive("{'Type':'!','Result':'CODEC','Value':2}");
+	std::string dictionary = stream.take();
+	CHECK(dictionary.find("DICT") != std::string::npos);
+	CHECK(dictionary.find(SHIELD_DICTIONARY) != std::string::npos);
+
+	screen.printAt(1, "Hi");
+	std::string written = stream.take();
+	CHECK_EQUAL(0xBF, static_cast<uint8_t>(written[0]));
+	CHECK(written.find("Message") == std::string::npos);
+
+	// already using tokens: the dictionary is not sent again
+	receive("{'Type':'!','Result':'CODEC','Value':2}");
+	CHECK_EQUAL("", stream.take());
+}
+
+TEST(connectOffersCborAgainWithoutTheDictionary)
+{
+	receive("{'Type':'!','Result':'CONNECT'}");
+	std::string start = stream.take();
+	CHECK(start.find("'Action':'START'") != std::string::npos);
+	CHECK(start.find("Dict") == std::string::npos);
+}
+
+TEST(dictionaryEntriesAreCheckedWhole)
+{
+	CHECK(VirtualShield::isDictionaryEntry("Service"));
+	CHECK(VirtualShield::isDictionaryEntry("Batch"));
+	CHECK(!VirtualShield::isDictionaryEntry("Serv"));
+	CHECK(!VirtualShield::isDictionaryEntry("Services"));
+	CHECK(!VirtualShield::isDictionaryEntry(""));
+}
+
+int main()
+{
+	return HostTest::run();
+}
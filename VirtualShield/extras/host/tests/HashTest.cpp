@@ -0,0 +1,95 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+
+// The hash a 16-bit board computes (int is 16 bits on AVR), for comparison with the low bits of the host's.
+static uint16_t boardHash(const char* s)
+{
+	uint16_t hash = 0;
+	while (*s)
+	{
+		hash = static_cast<uint16_t>(hash * 101 + *s++);
+	}
+
+	return hash;
+}
+
+TEST(literalHashesMatchTheRuntimeHash)
+{
+	CHECK_EQUAL("pressed"_vsh, VirtualShield::hash("pressed"));
+	CHECK_EQUAL("released"_vsh, VirtualShield::hash("released"));
+	CHECK_EQUAL("REFRESH"_vsh, VirtualShield::hash("REFRESH"));
+	CHECK_EQUAL("a"_vsh, VirtualShield::hash("a"));
+	CHECK_EQUAL(""_vsh, VirtualShield::hash(""));
+	CHECK_EQUAL("A long result text, with punctuation!"_vsh, VirtualShield::hash("A long result text, with punctuation!"));
+}
+
+TEST(systemHashesMatchTheRuntimeHash)
+{
+	CHECK_EQUAL(REFRESH_HASH, VirtualShield::hash("REFRESH"));
+	CHECK_EQUAL(CONNECT_HASH, VirtualShield::hash("CONNECT"));
+	CHECK_EQUAL(PING_HASH, VirtualShield::hash("PING"));
+	CHECK_EQUAL(SUSPEND_HASH, VirtualShield::hash("SUSPEND"));
+	CHECK_EQUAL(RESUME_HASH, VirtualShield::hash("RESUME"));
+	CHECK_EQUAL(CODEC_HASH, VirtualShield::hash("CODEC"));
+	CHECK_EQUAL(CHUNK_HASH, VirtualShield::hash("CHUNK"));
+	CHECK_EQUAL(LAST_HASH, VirtualShield::hash("LAST"));
+	CHECK_EQUAL(BATCH_HASH, VirtualShield::hash("BATCH"));
+}
+
+TEST(theLowBitsMatchA16BitBoard)
+{
+	CHECK_EQUAL(boardHash("pressed"), static_cast<uint16_t>("pressed"_vsh));
+	CHECK_EQUAL(boardHash("CONNECT"), static_cast<uint16_t>(VirtualShield::hash("CONNECT")));
+	CHECK_EQUAL(boardHash("A long result text, with punctuation!"), static_cast<uint16_t>(VirtualShield::hash("A long result text, with punctuation!")));
+}
+
+TEST(lengthLimitedHashesMatchTheLiteral)
+{
+	CHECK_EQUAL("press"_vsh, VirtualShield::hash("pressed", 5));
+	CHECK_EQUAL(""_vsh, VirtualShield::hash("pressed", 0));
+	CHECK_EQUAL(0u, VirtualShield::hash(0));
+}
+
+TEST(parsedWordsMatchTheirLiterals)
+{
+	VirtualShield shield;
+	unsigned int hashes[3] = {};
+	CHECK_EQUAL(3, shield.parseToHash("turn on lights", hashes, 3));
+	CHECK_EQUAL("turn"_vsh, hashes[0]);
+	CHECK_EQUAL("on"_vsh, hashes[1]);
+	CHECK_EQUAL("lights"_vsh, hashes[2]);
+
+	CHECK_EQUAL(2, shield.parseToHash("red,green,blue", hashes, 2, ','));
+	CHECK_EQUAL("red"_vsh, hashes[0]);
+	CHECK_EQUAL("green"_vsh, hashes[1]);
+}
+
+int main()
+{
+	return HostTest::run();
+}
@@ -0,0 +1,138 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// A minimal test runner for the host build: TEST(name) registers a test, CHECK and CHECK_EQUAL report failures
+// and HostTest::run() runs every test of the file, returning non-zero (for ctest) when any failed.
+
+#ifndef HostTest_h
+#define HostTest_h
+
+#include "Arduino.h"
+#include "Host.h"
+#include "MockStream.h"
+
+#include <stdio.h>
+#include <string>
+
+class HostTest
+{
+public:
+	typedef void(*TestFunction)();
+
+	HostTest(const char* name, TestFunction function) : name(name), function(function), next(0)
+	{
+		HostTest** link = &first();
+		while (*link)
+		{
+			link = &(*link)->next;
+		}
+
+		*link = this;
+	}
+
+	static int run()
+	{
+		int failedTests = 0;
+		for (HostTest* test = first(); test; test = test->next)
+		{
+			int failuresBefore = failures();
+			Host::setClockStep(0);
+			Host::setMillis(1000);
+			test->function();
+			bool passed = failures() == failuresBefore;
+			failedTests += passed ? 0 : 1;
+			printf("%s %s\n", passed ? "PASS" : "FAIL", test->name);
+		}
+
+		return failedTests == 0 ? 0 : 1;
+	}
+
+	static void fail(const char* file, int line, const char* condition)
+	{
+		failures()++;
+		printf("  %s:%d: CHECK(%s) failed\n", file, line, condition);
+	}
+
+	static void fail(const char* file, int line, const char* expression, const std::string& expected, const std::string& actual)
+	{
+		failures()++;
+		printf("  %s:%d: %s\n    expected: %s\n    actual:   %s\n", file, line, expression, expected.c_str(), actual.c_str());
+	}
+
+	static std::string show(const std::string& value) { return "\"" + value + "\""; }
+	static std::string show(const char* value) { return value ? show(std::string(value)) : "(null)"; }
+	static std::string show(bool value) { return value ? "true" : "false"; }
+	static std::string show(long long value) { return std::to_string(value); }
+	static std::string show(unsigned long long value) { return std::to_string(value); }
+	static std::string show(double value) { return std::to_string(value); }
+	static std::string show(int value) { return std::to_string(value); }
+	static std::string show(unsigned int value) { return std::to_string(value); }
+	static std::string show(long value) { return std::to_string(value); }
+	static std::string show(unsigned long value) { return std::to_string(value); }
+
+	static bool same(const char* expected, const char* actual)
+	{
+		return expected && actual ? strcmp(expected, actual) == 0 : expected == actual;
+	}
+
+	template <typename T, typename U>
+	static bool same(const T& expected, const U& actual)
+	{
+		return expected == actual;
+	}
+
+private:
+	const char* name;
+	TestFunction function;
+	HostTest* next;
+
+	static HostTest*& first()
+	{
+		static HostTest* tests = 0;
+		return tests;
+	}
+
+	static int& failures()
+	{
+		static int count = 0;
+		return count;
+	}
+};
+
+#define TEST(name) \
+	static void name(); \
+	static HostTest name##Test(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) HostTest::fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		HostUncounted uncounted; \
+		if (!HostTest::same((expected), (actual))) \
+			HostTest::fail(__FILE__, __LINE__, "CHECK_EQUAL(" #expected ", " #actual ")", HostTest::show(expected), HostTest::show(actual)); \
+	} while (0)
+
+#endif
@@ -0,0 +1,82 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Text.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Text screen(shield);
+
+// Runs getEvent() every 100 ms for a while, as a sketch's loop would.
+static void idle(long ms)
+{
+	ShieldEvent event;
+	for (long elapsed = 0; elapsed < ms; elapsed += 100)
+	{
+		Host::advance(100);
+		shield.getEvent(&event);
+	}
+}
+
+TEST(idlePollsBackOffAndCountTheSkippedIntervals)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	idle(2000);
+	stream.take();
+	long sent = shield.keepalivesSent;
+	long saved = shield.keepalivesSaved;
+
+	idle(30000);
+
+	// backing off from one second: fewer polls than seconds, and every second without one counted
+	long polls = shield.keepalivesSent - sent;
+	CHECK(polls > 0 && polls < 10);
+	CHECK(shield.keepalivesSaved - saved > 30 - polls - 5);
+	CHECK(shield.keepalivesSaved - saved <= 30 - polls);
+}
+
+TEST(pollsWhileAResponseIsExpectedAreNotCounted)
+{
+	shield.setKeepalive(1000, 16000, 250);
+	long saved = shield.keepalivesSaved;
+	long sent = shield.keepalivesSent;
+
+	for (int i = 0; i < 5; i++)
+	{
+		screen.printAt(1, "waiting");
+		idle(600);
+	}
+
+	CHECK(shield.keepalivesSent > sent);
+	CHECK_EQUAL(saved, shield.keepalivesSaved);
+}
+
+int main()
+{
+	return HostTest::run();
+}
@@ -0,0 +1,132 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include <stdio.h>
+#include <string>
+
+#include "VirtualShield.h"
+#include "Graphics.h"
+#include "Accelerometer.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static Accelerometer accelerometer(shield);
+static char queue[256];
+
+static int answeredId = 0;
+static int rectangleId = 0;
+static std::string actionAfterWait;
+static std::string resultAfterWait;
+static std::string typeAfterWait;
+
+static std::string text(const char* value)
+{
+	return value ? value : "(null)";
+}
+
+// Draws on a press and waits for the screen to answer, as the examples' handlers do.
+static void onEvent(ShieldEvent* shieldEvent)
+{
+	if (shieldEvent->id != 1)
+	{
+		return;
+	}
+
+	rectangleId = screen.fillRectangle(1, 2, 30, 40, ARGB(0), "box");
+	actionAfterWait = text(shieldEvent->action);
+	resultAfterWait = text(shieldEvent->result);
+	typeAfterWait = text(shieldEvent->tag);
+}
+
+// A press, then what arrives while its handler waits: a sensor event, another answer and the awaited answer.
+static void receivePressAndAnswers(int awaitedId)
+{
+	char answer[64];
+	stream.receive("{'Type':'S','Id':1,'Result':'outer','Action':'pressed'}");
+	stream.receive("{'Type':'A','Id':2,'X':1,'Y':2,'Z':3}");
+	stream.receive("{'Type':'S','Id':3,'Result':'other','Action':'drawn'}");
+	snprintf(answer, sizeof(answer), "{'Type':'S','Id':%d,'Result':'drawn','Action':'drawn'}", awaitedId);
+	stream.receive(answer);
+}
+
+// The id the next request will get.
+static int nextId()
+{
+	shield.enableAutoBlocking(false);
+	int id = screen.printAt(1, "next") + 1;
+	shield.enableAutoBlocking(true);
+	stream.take();
+	return id;
+}
+
+static void dispatchAll()
+{
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+}
+
+TEST(aBlockingCallInAHandlerKeepsItsEvent)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	shield.setOnEvent(onEvent);
+	stream.take();
+
+	answeredId = nextId();
+	receivePressAndAnswers(answeredId);
+	dispatchAll();
+
+	CHECK_EQUAL(answeredId, rectangleId);
+	CHECK_EQUAL(std::string("pressed"), actionAfterWait);
+	CHECK_EQUAL(std::string("outer"), resultAfterWait);
+	CHECK_EQUAL(std::string("S"), typeAfterWait);
+	CHECK_EQUAL(3.0, accelerometer.Z);
+}
+
+TEST(aBlockingCallInAHandlerKeepsItsQueuedEvent)
+{
+	shield.setReceiveQueue(queue, sizeof(queue));
+	rectangleId = 0;
+	actionAfterWait = "";
+
+	answeredId = nextId();
+	receivePressAndAnswers(answeredId);
+	shield.poll();
+	dispatchAll();
+
+	CHECK_EQUAL(answeredId, rectangleId);
+	CHECK_EQUAL(std::string("pressed"), actionAfterWait);
+	CHECK_EQUAL(std::string("outer"), resultAfterWait);
+	CHECK_EQUAL(std::string("S"), typeAfterWait);
+}
+
+int main()
+{
+	return HostTest::run();
+}
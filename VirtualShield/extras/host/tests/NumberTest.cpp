@@ -0,0 +1,76 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Text.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Text screen(shield);
+
+// The text sent for a Message value.
+static std::string sent(EPtr value)
+{
+	stream.take();
+	screen.printAt(1, value);
+	std::string written = stream.take();
+	size_t start = written.find("'Message':");
+	size_t end = written.find_first_of(",}", start);
+	return start == std::string::npos ? written : written.substr(start + 10, end - start - 10);
+}
+
+TEST(fixedValuesDropTrailingZeros)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+
+	CHECK_EQUAL("1.25", sent(EPtr(MESSAGE, 1250L, Fixed, 3)));
+	CHECK_EQUAL("-0.005", sent(EPtr(MESSAGE, -5L, Fixed, 3)));
+	CHECK_EQUAL("12", sent(EPtr(MESSAGE, 12000L, Fixed, 3)));
+	CHECK_EQUAL("-2147483648", sent(EPtr(MESSAGE, -2147483647L - 1, Fixed, 0)));
+}
+
+TEST(fixedDecimalsAreRoundedToTheMaximumPrecision)
+{
+	CHECK_EQUAL("0", sent(EPtr(MESSAGE, 5L, Fixed, 12)));
+	CHECK_EQUAL("0", sent(EPtr(MESSAGE, -5L, Fixed, 12)));
+	CHECK_EQUAL("0.001235", sent(EPtr(MESSAGE, 1234567890L, Fixed, 12)));
+	CHECK_EQUAL("-0.002147", sent(EPtr(MESSAGE, -2147483647L - 1, Fixed, 12)));
+	CHECK_EQUAL("0.000001", sent(EPtr(MESSAGE, 5L, Fixed, 7)));
+}
+
+TEST(doublesKeepTheirPrecision)
+{
+	CHECK_EQUAL("21.5625", sent(EPtr(MESSAGE, 21.5625)));
+	CHECK_EQUAL("0.33", sent(EPtr(MESSAGE, 1.0 / 3, 2)));
+	CHECK_EQUAL("-1", sent(EPtr(MESSAGE, -1.0)));
+	CHECK_EQUAL("0.1", sent(EPtr(MESSAGE, 0.1, 12)));
+}
+
+int main()
+{
+	return HostTest::run();
+}
@@ -0,0 +1,83 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include <stdio.h>
+
+#include "VirtualShield.h"
+#include "Protothread.h"
+#include "Text.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Text screen(shield);
+static Protothread greeter;
+static PendingRequest requests[2];
+
+static ProtothreadState greet(Protothread* pt)
+{
+	PT_BEGIN(pt);
+	PT_AWAIT_REQUEST(pt, shield, screen.printAt(1, "Hi"), 5000);
+	PT_END(pt);
+}
+
+TEST(restartingReleasesTheAwaitedRequest)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	shield.setRequestTable(requests, 2);
+
+	// more restarts mid-wait than there are request entries
+	for (int i = 0; i < 20; i++)
+	{
+		CHECK_EQUAL(ProtothreadWaiting, greet(&greeter));
+		CHECK_EQUAL(RequestPending, greeter.requestState);
+		greeter.restart();
+	}
+
+	CHECK_EQUAL(0, shield.droppedRequests);
+}
+
+TEST(aCompletedAwaitHoldsNoEntry)
+{
+	greet(&greeter);
+	char message[48];
+	snprintf(message, sizeof(message), "{'Type':'S','Id':%d,'Result':'ok'}", greeter.id);
+	stream.receive(message);
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+
+	CHECK_EQUAL(ProtothreadEnded, greet(&greeter));
+	CHECK_EQUAL(RequestCompleted, greeter.requestState);
+	CHECK(greeter.awaiting == 0);
+	CHECK_EQUAL(RequestUnknown, shield.requestState(greeter.id));
+}
+
+int main()
+{
+	return HostTest::run();
+}
@@ -0,0 +1,113 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Graphics.h"
+
+#include <string>
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static char queue[256];
+
+static int depth = 0;
+static std::string innerResult;
+static std::string outerResultAfterInner;
+
+// Handles the first event by getting the next one, as a handler waiting for a response would.
+static void onEvent(ShieldEvent* shieldEvent)
+{
+	if (depth > 0)
+	{
+		innerResult = shieldEvent->result ? shieldEvent->result : "";
+		return;
+	}
+
+	depth++;
+	ShieldEvent inner;
+	shield.getEvent(&inner);
+	depth--;
+
+	outerResultAfterInner = shieldEvent->result ? shieldEvent->result : "";
+}
+
+static void dispatchAll()
+{
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+}
+
+TEST(queuedEventsAreDispatchedInOrder)
+{
+	shield.enableAutoBlocking(false);
+	shield.setReceiveQueue(queue, sizeof(queue));
+	shield.begin(stream);
+
+	stream.receive("{'Type':'S','Id':1,'Result':'first','Action':'pressed'}{'Type':'S','Id':2,'Result':'second','Action':'pressed'}");
+	shield.poll();
+
+	ShieldEvent event;
+	CHECK(shield.getEvent(&event));
+	CHECK_EQUAL(std::string("first"), std::string(event.result));
+	CHECK(shield.getEvent(&event));
+	CHECK_EQUAL(std::string("second"), std::string(event.result));
+	CHECK(!shield.getEvent(&event));
+}
+
+TEST(aNestedGetEventKeepsTheOuterEvent)
+{
+	shield.setOnEvent(onEvent);
+
+	stream.receive("{'Type':'S','Id':3,'Result':'outer','Action':'pressed'}{'Type':'S','Id':4,'Result':'inner','Action':'pressed'}");
+	shield.poll();
+	dispatchAll();
+
+	CHECK_EQUAL(std::string("inner"), innerResult);
+	CHECK_EQUAL(std::string("outer"), outerResultAfterInner);
+}
+
+TEST(aQueuedEventKeepsAPartlyReadMessage)
+{
+	shield.setOnEvent(0);
+	stream.receive("{'Type':'S','Id':5,'Result':'one','Action':'pressed'}{'Type':'S','Id':6,'Result':'two','Action':'pressed'}");
+	shield.poll();
+	stream.receive("{'Type':'S','Id':7,'Result':'par");
+	dispatchAll();
+
+	stream.receive("tial','Action':'pressed'}");
+
+	ShieldEvent event;
+	CHECK(shield.getEvent(&event));
+	CHECK_EQUAL(std::string("partial"), std::string(event.result ? event.result : ""));
+}
+
+int main()
+{
+	return HostTest::run();
+}
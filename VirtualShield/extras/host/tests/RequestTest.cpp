@@ -0,0 +1,173 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include <stdio.h>
+
+#include "VirtualShield.h"
+#include "Text.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Text screen(shield);
+static char sent[256];
+static PendingRequest requests[8];
+static int completions = 0;
+
+static void onComplete(int, ShieldEvent*)
+{
+	completions++;
+}
+
+// Receives a message; returns the id of the last event it produced (0 when suppressed or none).
+static int receive(const char* message, ShieldEvent& event)
+{
+	stream.receive(message);
+	int id = 0;
+	while (shield.getEvent(&event))
+	{
+		id = event.id;
+	}
+
+	return id;
+}
+
+static void answer(int id)
+{
+	char message[48];
+	snprintf(message, sizeof(message), "{'Type':'S','Id':%d,'Result':'ok'}", id);
+	ShieldEvent event;
+	receive(message, event);
+}
+
+TEST(nothingIsTrackedWithoutATable)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	CHECK(shield.track(1) < 0);
+	CHECK_EQUAL(RequestUnknown, shield.requestState(1));
+	CHECK_EQUAL(0, shield.droppedRequests);
+}
+
+TEST(trackingAnIdAgainKeepsOneEntry)
+{
+	shield.setRequestTable(requests, 8);
+	shield.track(1, onComplete);
+	shield.track(2, onComplete);
+	shield.untrack(1);
+
+	// the entry freed ahead of id 2 is not taken by it
+	shield.track(2, onComplete);
+	answer(2);
+	CHECK_EQUAL(1, completions);
+	CHECK_EQUAL(RequestUnknown, shield.requestState(2));
+}
+
+TEST(untrackedRequestsAreNotCompleted)
+{
+	completions = 0;
+	shield.track(3, onComplete);
+	shield.untrack(3);
+	answer(3);
+	CHECK_EQUAL(0, completions);
+	CHECK_EQUAL(RequestUnknown, shield.requestState(3));
+}
+
+TEST(unreadFinalStatesAreReclaimedAfterTheirLifetime)
+{
+	for (int id = 10; id < 18; id++)
+	{
+		CHECK_EQUAL(id, shield.track(id));
+		answer(id);
+	}
+
+	int dropped = shield.droppedRequests;
+	CHECK(shield.track(20) < 0);
+	CHECK_EQUAL(dropped + 1, shield.droppedRequests);
+	CHECK_EQUAL(RequestCompleted, shield.requestState(10));
+
+	Host::advance(30000);
+	CHECK_EQUAL(20, shield.track(20));
+	CHECK_EQUAL(RequestPending, shield.requestState(20));
+	shield.untrack(20);
+}
+
+TEST(onlyRepeatedAnswersToResentRequestsAreSuppressed)
+{
+	shield.setRetransmitBuffer(sent, sizeof(sent), 2, 1000);
+	int id = screen.printAt(1, "resent");
+	shield.track(id);
+	Host::advance(1100);
+	ShieldEvent event;
+	shield.getEvent(&event);
+	CHECK_EQUAL(1, shield.retransmits);
+
+	answer(id);
+	CHECK_EQUAL(RequestCompleted, shield.requestState(id));
+
+	// a press on the same id is not the copy's answer
+	char message[64];
+	snprintf(message, sizeof(message), "{'Type':'S','Id':%d,'Action':'pressed'}", id);
+	CHECK_EQUAL(id, receive(message, event));
+	CHECK_EQUAL(0, shield.duplicatesSuppressed);
+
+	snprintf(message, sizeof(message), "{'Type':'S','Id':%d,'Result':'ok'}", id);
+	CHECK_EQUAL(0, receive(message, event));
+	CHECK_EQUAL(1, shield.duplicatesSuppressed);
+
+	// only as many as were resent
+	CHECK_EQUAL(id, receive(message, event));
+	CHECK_EQUAL(1, shield.duplicatesSuppressed);
+	shield.setRetransmitBuffer(0, 0);
+}
+
+TEST(aPressIsNoAnswerToWaitForAll)
+{
+	int ids[] = { screen.printAt(1, "one"), screen.printAt(2, "two"), -1 };
+	char message[96];
+	snprintf(message, sizeof(message), "{'Type':'S','Id':%d,'Action':'pressed'}{'Type':'S','Id':%d,'Result':'ok'}",
+		ids[0], ids[1]);
+	stream.receive(message);
+
+	Host::setClockStep(1000);
+	CHECK_EQUAL(1, shield.waitForAll(ids, 3, 100));
+	CHECK_EQUAL(0, shield.waitForAny(ids, 1, 100));
+
+	snprintf(message, sizeof(message), "{'Type':'S','Id':%d,'Result':'ok'}", ids[0]);
+	stream.receive(message);
+	CHECK_EQUAL(ids[0], shield.waitForAny(ids, 1, 100));
+}
+
+TEST(waitForAllRejectsMoreThan32Ids)
+{
+	int ids[33] = { 0 };
+	CHECK(shield.waitForAll(ids, 33, 100) < 0);
+	CHECK_EQUAL(0, shield.waitForAll(ids, 32, 0));
+}
+
+int main()
+{
+	return HostTest::run();
+}
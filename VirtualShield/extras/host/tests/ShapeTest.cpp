@@ -0,0 +1,126 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Graphics.h"
+#include "Accelerometer.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static Accelerometer accelerometer(shield);
+static OutputCacheEntry outputCache[8];
+
+// The message without its id, which changes with every call.
+static std::string withoutId(const std::string& message)
+{
+	size_t id = message.find(",'Id':");
+	size_t next = message.find(',', id + 1);
+	return id == std::string::npos || next == std::string::npos ? message : message.substr(0, id) + message.substr(next);
+}
+
+TEST(lineIsWrittenFromItsShape)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	stream.take();
+
+	screen.line(1, 2, 3, 4, ARGB(0));
+	CHECK_EQUAL("{'Service':'LCDG','Action':'LINE','Y':2,'X':1,'X2':3,'Y2':4,'TYPE':'S'}", withoutId(stream.take()));
+
+	screen.line(1, 2, 3, 4, ARGB(0xff00ff00), 3);
+	CHECK_EQUAL("{'Service':'LCDG','Action':'LINE','Y':2,'X':1,'X2':3,'Y2':4,'TYPE':'S','ARGB':4278255360,'Width':3}",
+		withoutId(stream.take()));
+}
+
+TEST(rectangleIsWrittenFromItsShape)
+{
+	screen.fillRectangle(1, 2, 30, 40, ARGB(0xff00ff00), "tag");
+	CHECK_EQUAL("{'Service':'LCDG','Action':'RECTANGLE','Y':2,'X':1,'Width':30,'Height':40,'TYPE':'S','ARGB':4278255360,'Tag':'tag'}",
+		withoutId(stream.take()));
+}
+
+TEST(printAtIsWrittenFromItsShape)
+{
+	screen.printAt(2, "it's");
+	CHECK_EQUAL("{'Service':'LCDT','Y':2,'Message':'it\\'s','TYPE':'S'}", withoutId(stream.take()));
+
+	screen.printAt(3, 2.5);
+	CHECK_EQUAL("{'Service':'LCDT','Y':3,'Message':2.5,'TYPE':'S'}", withoutId(stream.take()));
+}
+
+TEST(sensorRequestsAreKeyedByTheSensorType)
+{
+	accelerometer.start();
+	CHECK_EQUAL("{'Service':'SENSORS','Sensors':[{'A':2}]}", withoutId(stream.take()));
+
+	accelerometer.start(0.5, 100);
+	CHECK_EQUAL("{'Service':'SENSORS','Sensors':[{'A':2,'Delta':0.5,'Interval':100}]}", withoutId(stream.take()));
+}
+
+TEST(shapesUseTheOutputCache)
+{
+	shield.setOutputCache(outputCache, 8);
+
+	int id = screen.printAt(2, "same");
+	CHECK(id > 0);
+	stream.take();
+
+	CHECK_EQUAL(id, screen.printAt(2, "same"));
+	CHECK_EQUAL("", stream.take());
+	CHECK_EQUAL(1, shield.outputCacheHits);
+
+	CHECK(screen.printAt(2, "changed") > id);
+	CHECK(stream.take().find("'Message':'changed'") != std::string::npos);
+
+	int rectangle = screen.fillRectangle(1, 2, 30, 40, ARGB(0), "tag");
+	stream.take();
+	CHECK_EQUAL(rectangle, screen.fillRectangle(1, 2, 30, 40, ARGB(0), "tag"));
+	CHECK(screen.fillRectangle(1, 2, 30, 40, ARGB(0xff00ff00), "tag") > rectangle);
+	stream.take();
+
+	shield.setOutputCache(0, 0);
+}
+
+TEST(binaryEncodingsFallBackToEPtrs)
+{
+	stream.receive("{'Type':'!','Result':'CODEC','Value':1}");
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+
+	stream.take();
+	CHECK(screen.line(1, 2, 3, 4, ARGB(0)) > 0);
+	std::string written = stream.take();
+	CHECK_EQUAL(0xBF, static_cast<uint8_t>(written[0]));
+	CHECK(written.find("LINE") != std::string::npos);
+}
+
+int main()
+{
+	return HostTest::run();
+}
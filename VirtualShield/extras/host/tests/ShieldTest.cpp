@@ -0,0 +1,160 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "HostTest.h"
+
+#include "VirtualShield.h"
+#include "Graphics.h"
+#include "Accelerometer.h"
+
+static MockStream stream;
+static VirtualShield shield;
+static Graphics screen(shield);
+static Accelerometer accelerometer(shield);
+static int accelerometerEvents = 0;
+
+static void onAccelerometerEvent(ShieldEvent*)
+{
+	accelerometerEvents++;
+}
+
+// A listener remembering which sensor the events it receives name.
+class RecordingSensor : public Sensor
+{
+public:
+	Sensor* namedSensor = 0;
+
+	RecordingSensor(const VirtualShield& shield, char sensorType = 'K') : Sensor(shield, sensorType) {}
+
+	void onJsonReceived(JsonObject& root, ShieldEvent* shieldEvent) override
+	{
+		namedSensor = shieldEvent->shieldEventType == SensorShieldEventType ? static_cast<SensorEvent*>(shieldEvent)->sensor : 0;
+		Sensor::onJsonReceived(root, shieldEvent);
+	}
+};
+
+static RecordingSensor firstListener(shield);
+static RecordingSensor secondListener(shield);
+static RecordingSensor slotNeighbour(shield, 'E'); // shares the accelerometer's slot by default
+
+TEST(beginSendsStart)
+{
+	shield.enableAutoBlocking(false);
+	shield.begin(stream);
+	std::string written = stream.take();
+	CHECK(written.find("'Service':'SYSTEM'") != std::string::npos);
+	CHECK(written.find("'Action':'START'") != std::string::npos);
+}
+
+TEST(printAtWritesOneTimestampedMessage)
+{
+	Host::setMillis(5000);
+	int id = screen.printAt(2, "Hello");
+	CHECK(id > 0);
+	CHECK_EQUAL(1u, stream.writes.size());
+	CHECK_EQUAL(5000000ul, stream.writes[0].micros);
+	std::string written = stream.take();
+	CHECK(written.find("'Service':'LCDT'") != std::string::npos);
+	CHECK(written.find("'Message':'Hello'") != std::string::npos);
+}
+
+TEST(eventsReachTheirSensor)
+{
+	accelerometer.setOnEvent(onAccelerometerEvent);
+	stream.receive("{'Type':'A','Id':5,'X':0.5,'Y':-1,'Z':2}");
+	ShieldEvent event = {};
+	while (shield.getEvent(&event))
+	{
+	}
+
+	CHECK_EQUAL(1, accelerometerEvents);
+	CHECK_EQUAL(0.5, accelerometer.X);
+	CHECK_EQUAL(-1.0, accelerometer.Y);
+	CHECK_EQUAL(2.0, accelerometer.Z);
+}
+
+TEST(eachListenerSeesItselfAsTheSensor)
+{
+	stream.receive("{'Type':'K','Id':6,'Value':1}");
+	SensorEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+
+	CHECK(firstListener.namedSensor == &firstListener);
+	CHECK(secondListener.namedSensor == &secondListener);
+	CHECK(event.sensor == &firstListener);
+}
+
+TEST(sensorsSharingASlotOnlyGetTheirOwnEvents)
+{
+	int before = accelerometerEvents;
+	stream.receive("{'Type':'A','Id':7,'X':1,'Y':1,'Z':1}");
+	SensorEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+
+	CHECK_EQUAL(before + 1, accelerometerEvents);
+	CHECK(slotNeighbour.namedSensor == 0);
+
+	stream.receive("{'Type':'E','Id':8,'Value':1}");
+	while (shield.getEvent(&event))
+	{
+	}
+
+	CHECK_EQUAL(before + 1, accelerometerEvents);
+	CHECK(slotNeighbour.namedSensor == &slotNeighbour);
+	CHECK(event.sensor == &slotNeighbour);
+}
+
+TEST(tagsAndActionsAreMatchedByHashAndText)
+{
+	stream.receive("{'Type':'S','Id':9,'Tag':'go','Action':'pressed'}");
+	ShieldEvent event;
+	while (shield.getEvent(&event))
+	{
+	}
+
+	CHECK(screen.isPressed("go"));
+	CHECK(!screen.isPressed("gone"));
+	CHECK(!screen.isReleased("go"));
+	CHECK(screen.isEvent("go", "pressed", &screen.recentEvent));
+	CHECK(!screen.isEvent("go", "released", &screen.recentEvent));
+	CHECK(screen.isEvent(9, "pressed", &screen.recentEvent));
+	CHECK(!screen.isEvent(9, 0, &screen.recentEvent));
+}
+
+TEST(beginWithBitRateOpensTheChosenPort)
+{
+	VirtualShield serialShield;
+	serialShield.setPort(0);
+	serialShield.begin(57600);
+	CHECK_EQUAL(57600ul, Serial.baud);
+}
+
+int main()
+{
+	return HostTest::run();
+}